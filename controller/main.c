@@ -21,9 +21,11 @@
 #include "adc.h"
 #include "pid.h"
 #include "uart.h"
+#include "telemetry.h"
 
 #define DISPLAY_MODI 11
 #define BAUDRATE 57600
+#define TELEMETRY_DIVIDER 4 /* Frame alle 4 Regelzyklen => 244 Hz */
 
 #define MAGIC_BYTE 0xca
 #define MAGIC_LEN 16
@@ -108,6 +110,8 @@ uint8_t speed;
 uint16_t speed_cnt;
 bool speed_ovf = true;
 
+uint16_t tick; /* Timer 2 Overflows */
+
 struct pid pid_drive;
 struct pid pid_stering;
 
@@ -148,9 +152,6 @@ void parameter_edit(int16_t *parameter, int16_t *parameter_ee, enum taster input
  * Startsequenz
  */
 void greeter() {
-	// UART
-	uart_puts("Donaudampfschiff\r\n");
-
 	// LCD
 	lcd_clear();
 	lcd_string("Donaudampfschiff");
@@ -160,6 +161,32 @@ void greeter() {
 	lcd_clear();
 }
 
+/**
+ * Telemetrie-Frame senden
+ *
+ * Wird im Interrupt aufgerufen: keine Formatierung, nur Packen der Rohwerte.
+ * Ist der Sendepuffer voll, wird der Frame verworfen (Lcke in der Sequenznummer).
+ */
+static void telemetry_send() {
+	static uint8_t seq;
+	struct telemetry t;
+	uint8_t payload[TELEMETRY_PAYLOAD_LEN];
+	uint8_t frame[TELEMETRY_FRAME_LEN];
+
+	t.seq = seq++;
+	t.tick = tick;
+	t.adc[0] = adc_stering_left;
+	t.adc[1] = adc_stering_right;
+	t.adc[2] = adc_batt_logic;
+	t.adc[3] = adc_batt_drive;
+	t.speed = speed;
+	t.out_stering = out_stering;
+	t.out_drive = out_drive;
+
+	telemetry_pack(payload, &t);
+	uart_write(frame, telemetry_encode(frame, payload, sizeof(payload)));
+}
+
 /**
  * Initialize Timers and IO Ports
  */
@@ -285,35 +312,7 @@ ISR(TIMER0_OVF_vect) {
  * Interupt Subroutine fr UART Kommunikation
  */
 ISR(TIMER1_OVF_vect) {
-	static uint8_t cnt, cnt2, magic, dat = 1;
-	char buffer[32];
-
-	/* Send Data */
-	/*if (cnt++ == 25) {
-
-		switch (cnt2++ & 0x01) {
-			case 0:
-				sprintf(buffer,
-					"spd=%i, adc_r=%i, adc_l=%i, ",
-					speed,
-					adc_stering_right,
-					adc_stering_left
-				);
-				break;
-
-			case 1:
-				sprintf(buffer,
-					"stering=%i, drive=%i\r\n",
-					out_stering,
-					out_drive
-				);
-				break;
-		}
-
-		uart_puts(buffer);
-
-		cnt = 0;
-	}*/
+	static uint8_t magic, dat = 1;
 
 	/*uint16_t byte = uart_getc();
 	if (byte != UART_NO_DATA) {
@@ -330,6 +329,9 @@ ISR(TIMER1_OVF_vect) {
  * Interupt Subroutine fr Regelung
  */
 ISR(TIMER2_OVF_vect) {
+	static uint8_t telemetry_cnt;
+
+	tick++;
 	speed_cnt++;
 	speed_ovf |= (speed_cnt == INT16_MAX);
 
@@ -379,6 +381,14 @@ ISR(TIMER2_OVF_vect) {
 	 */
 	OCR1A = 3000 + (out_stering * 9);
 	OCR2 = out_drive;
+
+	/**
+	 * Telemetrie
+	 */
+	if (++telemetry_cnt == TELEMETRY_DIVIDER) {
+		telemetry_send();
+		telemetry_cnt = 0;
+	}
 }
 
 
@@ -450,6 +460,9 @@ int main() {
 		eeprom_read_word((uint16_t *) &pid_stering_i_ee),
 		0, &pid_stering);
 
+	// Begrung vor sei(): uart_puts() und der Telemetrie-Interrupt schreiben beide UART_TxHead
+	uart_puts("Donaudampfschiff\r\n");
+
 	// Interrupts aktivieren
 	sei();
 
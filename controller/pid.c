@@ -40,8 +40,9 @@ void pid_init(int16_t pFactor, int16_t iFactor, int16_t dFactor, struct pid *pid
 	pid->dFactor = dFactor;
 
 	// Limits to avoid overflow
-	pid->maxError = MAX_INT / (pid->pFactor + 1);
-	pid->maxSumError = MAX_I_TERM / (pid->iFactor + 1);
+	// The casts keep the 16 bit int arithmetic of the AVR on other hosts
+	pid->maxError = MAX_INT / (int16_t) (pid->pFactor + 1);
+	pid->maxSumError = MAX_I_TERM / (int16_t) (pid->iFactor + 1);
 }
 
 /**
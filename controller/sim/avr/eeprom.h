@@ -0,0 +1,17 @@
+/**
+ * Simulated EEPROM: EEMEM variables are kept in RAM
+ */
+
+#ifndef _AVR_EEPROM_H_
+#define _AVR_EEPROM_H_
+
+#include <stdint.h>
+
+#define EEMEM
+
+#define eeprom_read_word(p)		(*(const uint16_t *) (p))
+#define eeprom_write_word(p, v)		(*(uint16_t *) (p) = (v))
+#define eeprom_read_byte(p)		(*(const uint8_t *) (p))
+#define eeprom_write_byte(p, v)		(*(uint8_t *) (p) = (v))
+
+#endif /* _AVR_EEPROM_H_ */
@@ -0,0 +1,31 @@
+/**
+ * Simulated interrupt handling (see sim/sim.h)
+ *
+ * ISRs become plain functions named after their vector which are called
+ * by the simulator.
+ */
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include "../sim.h"
+
+#define ISR(vector)	void vector(void); void vector(void)
+#define SIGNAL(vector)	ISR(vector)
+
+#define sei()		sim_sei()
+#define cli()		sim_cli()
+
+/* legacy names used by uart.c */
+#define SIG_UART_RECV	USART_RXC_vect
+#define SIG_UART_DATA	USART_UDRE_vect
+
+void INT0_vect(void);
+void TIMER2_OVF_vect(void);
+void TIMER1_OVF_vect(void);
+void TIMER0_OVF_vect(void);
+void USART_RXC_vect(void);
+void USART_UDRE_vect(void);
+void ADC_vect(void);
+
+#endif /* _AVR_INTERRUPT_H_ */
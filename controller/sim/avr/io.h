@@ -0,0 +1,172 @@
+/**
+ * Simulated ATmega32 registers (see sim/sim.h)
+ *
+ * Only the registers and bits used by the firmware are defined.
+ * The addresses are the I/O addresses of the ATmega32.
+ */
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <stdint.h>
+
+#include "../sim.h"
+
+#define _SFR_IO8(addr)	(*sim_io8(addr))
+#define _SFR_IO16(addr)	(*sim_io16(addr))
+#define _BV(bit)	(1 << (bit))
+
+#define RAMEND		0x85F
+
+#define SREG	_SFR_IO8(0x3F)
+#define GICR	_SFR_IO8(0x3B)
+#define TIMSK	_SFR_IO8(0x39)
+#define MCUCR	_SFR_IO8(0x35)
+#define TCCR0	_SFR_IO8(0x33)
+#define TCNT0	_SFR_IO8(0x32)
+#define TCCR1A	_SFR_IO8(0x2F)
+#define TCCR1B	_SFR_IO8(0x2E)
+#define OCR1A	_SFR_IO16(0x2A)
+#define OCR1B	_SFR_IO16(0x28)
+#define ICR1	_SFR_IO16(0x26)
+#define TCCR2	_SFR_IO8(0x25)
+#define OCR2	_SFR_IO8(0x23)
+#define UBRRH	_SFR_IO8(0x20)
+#define UCSRC	_SFR_IO8(0x40)	/* shares 0x20 with UBRRH on the real chip */
+#define PORTA	_SFR_IO8(0x1B)
+#define DDRA	_SFR_IO8(0x1A)
+#define PINA	_SFR_IO8(0x19)
+#define PORTB	_SFR_IO8(0x18)
+#define DDRB	_SFR_IO8(0x17)
+#define PINB	_SFR_IO8(0x16)
+#define PORTC	_SFR_IO8(0x15)
+#define DDRC	_SFR_IO8(0x14)
+#define PINC	_SFR_IO8(0x13)
+#define PORTD	_SFR_IO8(0x12)
+#define DDRD	_SFR_IO8(0x11)
+#define PIND	_SFR_IO8(0x10)
+#define UDR	_SFR_IO8(0x0C)
+#define UCSRA	_SFR_IO8(0x0B)
+#define UCSRB	_SFR_IO8(0x0A)
+#define UBRRL	_SFR_IO8(0x09)
+#define ADMUX	_SFR_IO8(0x07)
+#define ADCSRA	_SFR_IO8(0x06)
+#define ADC	_SFR_IO16(0x04)
+
+/* MCUCR */
+#define ISC01	1
+#define ISC00	0
+
+/* GICR */
+#define INT0	6
+
+/* TIMSK */
+#define TOIE2	6
+#define TOIE1	2
+#define TOIE0	0
+
+/* TCCR0 */
+#define FOC0	7
+#define WGM00	6
+#define COM01	5
+#define COM00	4
+#define WGM01	3
+#define CS02	2
+#define CS01	1
+#define CS00	0
+
+/* TCCR1A */
+#define COM1A1	7
+#define COM1A0	6
+#define COM1B1	5
+#define COM1B0	4
+#define WGM11	1
+#define WGM10	0
+
+/* TCCR1B */
+#define WGM13	4
+#define WGM12	3
+#define CS12	2
+#define CS11	1
+#define CS10	0
+
+/* TCCR2 */
+#define FOC2	7
+#define WGM20	6
+#define COM21	5
+#define COM20	4
+#define WGM21	3
+#define CS22	2
+#define CS21	1
+#define CS20	0
+
+/* ADMUX */
+#define REFS1	7
+#define REFS0	6
+#define ADLAR	5
+
+/* ADCSRA */
+#define ADEN	7
+#define ADSC	6
+#define ADATE	5
+#define ADIF	4
+#define ADIE	3
+#define ADPS2	2
+#define ADPS1	1
+#define ADPS0	0
+
+/* UCSRA */
+#define RXC	7
+#define TXC	6
+#define UDRE	5
+#define FE	4
+#define DOR	3
+#define U2X	1
+
+/* UCSRB */
+#define RXCIE	7
+#define TXCIE	6
+#define UDRIE	5
+#define RXEN	4
+#define TXEN	3
+
+/* UCSRC */
+#define URSEL	7
+#define UCSZ1	2
+#define UCSZ0	1
+
+/* Ports */
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#endif /* _AVR_IO_H_ */
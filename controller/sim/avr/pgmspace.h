@@ -0,0 +1,12 @@
+/**
+ * Simulated program memory: there is only one address space on the host
+ */
+
+#ifndef _AVR_PGMSPACE_H_
+#define _AVR_PGMSPACE_H_
+
+#define PROGMEM
+#define PSTR(s)			(s)
+#define pgm_read_byte(p)	(*(const unsigned char *) (p))
+
+#endif /* _AVR_PGMSPACE_H_ */
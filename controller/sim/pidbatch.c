@@ -0,0 +1,433 @@
+/**
+ * Batched evaluation of the PID controller on the host
+ *
+ * pid_controller() relies on the 16 bit int of the AVR in two places:
+ * pTerm and dTerm are truncated to int16_t. Each lane computes with 32 bit
+ * and truncates at the same points, so the results are bit-exact. The
+ * saturation limits are copied from pid_init() by pid_batch_load().
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "pidbatch.h"
+
+#define SEXT16(x) ((int32_t) (int16_t) (x))
+
+/**
+ * Registers of one lane, shared by all kernels
+ */
+struct lane {
+	int32_t last, sum, p, i, d, maxE, maxS;
+};
+
+static inline int16_t lane_step(struct lane *l, int32_t setPoint, int32_t processValue) {
+	int32_t error, pTerm, iTerm, dTerm, temp, ret;
+
+	error = SEXT16(setPoint - processValue);
+
+	if (error > l->maxE)
+		pTerm = MAX_INT;
+	else if (error < -l->maxE)
+		pTerm = -MAX_INT;
+	else
+		pTerm = SEXT16(l->p * error);
+
+	temp = l->sum + error;
+	if (temp > l->maxS) {
+		iTerm = MAX_I_TERM;
+		l->sum = l->maxS;
+	}
+	else if (temp < -l->maxS) {
+		iTerm = -MAX_I_TERM;
+		l->sum = -l->maxS;
+	}
+	else {
+		l->sum = temp;
+		iTerm = (int32_t) ((uint32_t) l->i * (uint32_t) temp);
+	}
+
+	dTerm = SEXT16(l->d * (l->last - processValue));
+	l->last = processValue;
+
+	ret = (pTerm + iTerm + dTerm) >> SCALING_SHIFT;
+
+	if (ret > MAX_INT)
+		ret = MAX_INT;
+	else if (ret < -MAX_INT)
+		ret = -MAX_INT;
+
+	return ret;
+}
+
+static inline void lane_load(const struct pid_batch *b, size_t k, struct lane *l) {
+	l->last = b->lastProcessValue[k];
+	l->sum = b->sumError[k];
+	l->p = b->pFactor[k];
+	l->i = b->iFactor[k];
+	l->d = b->dFactor[k];
+	l->maxE = b->maxError[k];
+	l->maxS = b->maxSumError[k];
+}
+
+static inline void lane_save(struct pid_batch *b, size_t k, const struct lane *l) {
+	b->lastProcessValue[k] = l->last;
+	b->sumError[k] = l->sum;
+}
+
+static void scalar_step(struct pid_batch *b, size_t from, const int16_t *sp, const int16_t *pv, int16_t *out) {
+	struct lane l;
+	size_t k;
+
+	for (k = from; k < b->count; k++) {
+		lane_load(b, k, &l);
+		out[k] = lane_step(&l, sp[k], pv[k]);
+		lane_save(b, k, &l);
+	}
+}
+
+static void scalar_run(struct pid_batch *b, size_t from, const int16_t *sp, const int16_t *pv, size_t samples, int16_t *out) {
+	struct lane l;
+	size_t k, t;
+
+	for (k = from; k < b->count; k++) {
+		lane_load(b, k, &l);
+
+		if (out) {
+			for (t = 0; t < samples; t++)
+				out[t * b->count + k] = lane_step(&l, sp[t], pv[t]);
+		}
+		else {
+			for (t = 0; t < samples; t++)
+				lane_step(&l, sp[t], pv[t]);
+		}
+
+		lane_save(b, k, &l);
+	}
+}
+
+/*
+ * Vector kernels
+ *
+ * The branches of lane_step() become masks. Where lane_step() checks the
+ * upper limit first, the upper limit is blended last so it wins.
+ */
+
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+struct sse41 {
+	__m128i last, sum, p, i, d, maxE, maxS;
+};
+
+SSE41 static inline __m128i sse41_sext16(__m128i x) {
+	return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+SSE41 static inline __m128i sse41_step(struct sse41 *r, __m128i sp, __m128i pv) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i error, pTerm, iTerm, dTerm, temp, ret, negE, negS, gt, lt;
+
+	error = sse41_sext16(_mm_sub_epi32(sp, pv));
+
+	negE = _mm_sub_epi32(zero, r->maxE);
+	gt = _mm_cmpgt_epi32(error, r->maxE);
+	lt = _mm_cmpgt_epi32(negE, error);
+	pTerm = sse41_sext16(_mm_mullo_epi32(r->p, error));
+	pTerm = _mm_blendv_epi8(pTerm, _mm_set1_epi32(-MAX_INT), lt);
+	pTerm = _mm_blendv_epi8(pTerm, _mm_set1_epi32(MAX_INT), gt);
+
+	temp = _mm_add_epi32(r->sum, error);
+	negS = _mm_sub_epi32(zero, r->maxS);
+	gt = _mm_cmpgt_epi32(temp, r->maxS);
+	lt = _mm_cmpgt_epi32(negS, temp);
+	iTerm = _mm_mullo_epi32(r->i, temp);
+	iTerm = _mm_blendv_epi8(iTerm, _mm_set1_epi32(-MAX_I_TERM), lt);
+	iTerm = _mm_blendv_epi8(iTerm, _mm_set1_epi32(MAX_I_TERM), gt);
+	r->sum = _mm_blendv_epi8(temp, negS, lt);
+	r->sum = _mm_blendv_epi8(r->sum, r->maxS, gt);
+
+	dTerm = sse41_sext16(_mm_mullo_epi32(r->d, _mm_sub_epi32(r->last, pv)));
+	r->last = pv;
+
+	ret = _mm_add_epi32(_mm_add_epi32(pTerm, iTerm), dTerm);
+	ret = _mm_srai_epi32(ret, SCALING_SHIFT);
+	ret = _mm_min_epi32(ret, _mm_set1_epi32(MAX_INT));
+	ret = _mm_max_epi32(ret, _mm_set1_epi32(-MAX_INT));
+
+	return ret;
+}
+
+SSE41 static inline void sse41_load(const struct pid_batch *b, size_t k, struct sse41 *r) {
+	r->last = _mm_load_si128((const __m128i *) (b->lastProcessValue + k));
+	r->sum = _mm_load_si128((const __m128i *) (b->sumError + k));
+	r->p = _mm_load_si128((const __m128i *) (b->pFactor + k));
+	r->i = _mm_load_si128((const __m128i *) (b->iFactor + k));
+	r->d = _mm_load_si128((const __m128i *) (b->dFactor + k));
+	r->maxE = _mm_load_si128((const __m128i *) (b->maxError + k));
+	r->maxS = _mm_load_si128((const __m128i *) (b->maxSumError + k));
+}
+
+SSE41 static inline void sse41_save(struct pid_batch *b, size_t k, const struct sse41 *r) {
+	_mm_store_si128((__m128i *) (b->lastProcessValue + k), r->last);
+	_mm_store_si128((__m128i *) (b->sumError + k), r->sum);
+}
+
+SSE41 static void sse41_step_all(struct pid_batch *b, const int16_t *sp, const int16_t *pv, int16_t *out) {
+	struct sse41 r;
+	size_t k;
+
+	for (k = 0; k + 4 <= b->count; k += 4) {
+		__m128i s = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *) (sp + k)));
+		__m128i p = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *) (pv + k)));
+		__m128i ret;
+
+		sse41_load(b, k, &r);
+		ret = sse41_step(&r, s, p);
+		_mm_storel_epi64((__m128i *) (out + k), _mm_packs_epi32(ret, ret));
+		sse41_save(b, k, &r);
+	}
+
+	scalar_step(b, k, sp, pv, out);
+}
+
+SSE41 static void sse41_run(struct pid_batch *b, const int16_t *sp, const int16_t *pv, size_t samples, int16_t *out) {
+	struct sse41 r;
+	size_t k, t;
+
+	for (k = 0; k + 4 <= b->count; k += 4) {
+		sse41_load(b, k, &r);
+
+		for (t = 0; t < samples; t++) {
+			__m128i ret = sse41_step(&r, _mm_set1_epi32(sp[t]), _mm_set1_epi32(pv[t]));
+
+			if (out)
+				_mm_storel_epi64((__m128i *) (out + t * b->count + k), _mm_packs_epi32(ret, ret));
+		}
+
+		sse41_save(b, k, &r);
+	}
+
+	scalar_run(b, k, sp, pv, samples, out);
+}
+
+struct avx2 {
+	__m256i last, sum, p, i, d, maxE, maxS;
+};
+
+AVX2 static inline __m256i avx2_sext16(__m256i x) {
+	return _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+}
+
+AVX2 static inline __m256i avx2_step(struct avx2 *r, __m256i sp, __m256i pv) {
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i error, pTerm, iTerm, dTerm, temp, ret, negE, negS, gt, lt;
+
+	error = avx2_sext16(_mm256_sub_epi32(sp, pv));
+
+	negE = _mm256_sub_epi32(zero, r->maxE);
+	gt = _mm256_cmpgt_epi32(error, r->maxE);
+	lt = _mm256_cmpgt_epi32(negE, error);
+	pTerm = avx2_sext16(_mm256_mullo_epi32(r->p, error));
+	pTerm = _mm256_blendv_epi8(pTerm, _mm256_set1_epi32(-MAX_INT), lt);
+	pTerm = _mm256_blendv_epi8(pTerm, _mm256_set1_epi32(MAX_INT), gt);
+
+	temp = _mm256_add_epi32(r->sum, error);
+	negS = _mm256_sub_epi32(zero, r->maxS);
+	gt = _mm256_cmpgt_epi32(temp, r->maxS);
+	lt = _mm256_cmpgt_epi32(negS, temp);
+	iTerm = _mm256_mullo_epi32(r->i, temp);
+	iTerm = _mm256_blendv_epi8(iTerm, _mm256_set1_epi32(-MAX_I_TERM), lt);
+	iTerm = _mm256_blendv_epi8(iTerm, _mm256_set1_epi32(MAX_I_TERM), gt);
+	r->sum = _mm256_blendv_epi8(temp, negS, lt);
+	r->sum = _mm256_blendv_epi8(r->sum, r->maxS, gt);
+
+	dTerm = avx2_sext16(_mm256_mullo_epi32(r->d, _mm256_sub_epi32(r->last, pv)));
+	r->last = pv;
+
+	ret = _mm256_add_epi32(_mm256_add_epi32(pTerm, iTerm), dTerm);
+	ret = _mm256_srai_epi32(ret, SCALING_SHIFT);
+	ret = _mm256_min_epi32(ret, _mm256_set1_epi32(MAX_INT));
+	ret = _mm256_max_epi32(ret, _mm256_set1_epi32(-MAX_INT));
+
+	return ret;
+}
+
+/**
+ * Narrow 8 lanes to int16_t (values are already saturated)
+ */
+AVX2 static inline __m128i avx2_pack(__m256i x) {
+	x = _mm256_packs_epi32(x, x); /* packs within 128 bit halves */
+	x = _mm256_permute4x64_epi64(x, 0x08);
+
+	return _mm256_castsi256_si128(x);
+}
+
+AVX2 static inline void avx2_load(const struct pid_batch *b, size_t k, struct avx2 *r) {
+	r->last = _mm256_load_si256((const __m256i *) (b->lastProcessValue + k));
+	r->sum = _mm256_load_si256((const __m256i *) (b->sumError + k));
+	r->p = _mm256_load_si256((const __m256i *) (b->pFactor + k));
+	r->i = _mm256_load_si256((const __m256i *) (b->iFactor + k));
+	r->d = _mm256_load_si256((const __m256i *) (b->dFactor + k));
+	r->maxE = _mm256_load_si256((const __m256i *) (b->maxError + k));
+	r->maxS = _mm256_load_si256((const __m256i *) (b->maxSumError + k));
+}
+
+AVX2 static inline void avx2_save(struct pid_batch *b, size_t k, const struct avx2 *r) {
+	_mm256_store_si256((__m256i *) (b->lastProcessValue + k), r->last);
+	_mm256_store_si256((__m256i *) (b->sumError + k), r->sum);
+}
+
+AVX2 static void avx2_step_all(struct pid_batch *b, const int16_t *sp, const int16_t *pv, int16_t *out) {
+	struct avx2 r;
+	size_t k;
+
+	for (k = 0; k + 8 <= b->count; k += 8) {
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (sp + k)));
+		__m256i p = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (pv + k)));
+
+		avx2_load(b, k, &r);
+		_mm_storeu_si128((__m128i *) (out + k), avx2_pack(avx2_step(&r, s, p)));
+		avx2_save(b, k, &r);
+	}
+
+	scalar_step(b, k, sp, pv, out);
+}
+
+AVX2 static void avx2_run(struct pid_batch *b, const int16_t *sp, const int16_t *pv, size_t samples, int16_t *out) {
+	struct avx2 r;
+	size_t k, t;
+
+	for (k = 0; k + 8 <= b->count; k += 8) {
+		avx2_load(b, k, &r);
+
+		for (t = 0; t < samples; t++) {
+			__m256i ret = avx2_step(&r, _mm256_set1_epi32(sp[t]), _mm256_set1_epi32(pv[t]));
+
+			if (out)
+				_mm_storeu_si128((__m128i *) (out + t * b->count + k), avx2_pack(ret));
+		}
+
+		avx2_save(b, k, &r);
+	}
+
+	scalar_run(b, k, sp, pv, samples, out);
+}
+
+static int32_t * lanes(size_t count) {
+	void *p;
+	size_t size = (count + PID_BATCH_LANES - 1) / PID_BATCH_LANES * PID_BATCH_LANES * sizeof(int32_t);
+
+	if (posix_memalign(&p, 32, size ? size : 32))
+		return NULL;
+
+	memset(p, 0, size);
+
+	return p;
+}
+
+int pid_batch_init(struct pid_batch *b, size_t count) {
+	struct pid pid;
+	size_t k;
+
+	b->count = count;
+	b->lastProcessValue = lanes(count);
+	b->sumError = lanes(count);
+	b->pFactor = lanes(count);
+	b->iFactor = lanes(count);
+	b->dFactor = lanes(count);
+	b->maxError = lanes(count);
+	b->maxSumError = lanes(count);
+
+	if (!b->lastProcessValue || !b->sumError || !b->pFactor || !b->iFactor ||
+	    !b->dFactor || !b->maxError || !b->maxSumError) {
+		pid_batch_free(b);
+		return -1;
+	}
+
+	pid_init(0, 0, 0, &pid);
+	for (k = 0; k < count; k++)
+		pid_batch_load(b, k, &pid);
+
+	pid_batch_select(b, PID_BATCH_AUTO);
+
+	return 0;
+}
+
+void pid_batch_free(struct pid_batch *b) {
+	free(b->lastProcessValue);
+	free(b->sumError);
+	free(b->pFactor);
+	free(b->iFactor);
+	free(b->dFactor);
+	free(b->maxError);
+	free(b->maxSumError);
+
+	memset(b, 0, sizeof(*b));
+}
+
+enum pid_batch_isa pid_batch_select(struct pid_batch *b, enum pid_batch_isa isa) {
+	__builtin_cpu_init();
+
+	if (isa == PID_BATCH_AUTO)
+		isa = PID_BATCH_AVX2;
+
+	if (isa == PID_BATCH_AVX2 && !__builtin_cpu_supports("avx2"))
+		isa = PID_BATCH_SSE41;
+
+	if (isa == PID_BATCH_SSE41 && !__builtin_cpu_supports("sse4.1"))
+		isa = PID_BATCH_SCALAR;
+
+	return b->isa = isa;
+}
+
+const char * pid_batch_name(enum pid_batch_isa isa) {
+	switch (isa) {
+		case PID_BATCH_SCALAR:	return "scalar";
+		case PID_BATCH_SSE41:	return "sse4.1";
+		case PID_BATCH_AVX2:	return "avx2";
+		default:		return "auto";
+	}
+}
+
+void pid_batch_load(struct pid_batch *b, size_t i, const struct pid *pid) {
+	b->lastProcessValue[i] = pid->lastProcessValue;
+	b->sumError[i] = pid->sumError;
+	b->pFactor[i] = pid->pFactor;
+	b->iFactor[i] = pid->iFactor;
+	b->dFactor[i] = pid->dFactor;
+	b->maxError[i] = pid->maxError;
+	b->maxSumError[i] = pid->maxSumError;
+}
+
+void pid_batch_store(const struct pid_batch *b, size_t i, struct pid *pid) {
+	pid->lastProcessValue = b->lastProcessValue[i];
+	pid->sumError = b->sumError[i];
+	pid->pFactor = b->pFactor[i];
+	pid->iFactor = b->iFactor[i];
+	pid->dFactor = b->dFactor[i];
+	pid->maxError = b->maxError[i];
+	pid->maxSumError = b->maxSumError[i];
+}
+
+void pid_batch_step(struct pid_batch *b, const int16_t *setPoint, const int16_t *processValue, int16_t *out) {
+	switch (b->isa) {
+		case PID_BATCH_AVX2:	avx2_step_all(b, setPoint, processValue, out); break;
+		case PID_BATCH_SSE41:	sse41_step_all(b, setPoint, processValue, out); break;
+		default:		scalar_step(b, 0, setPoint, processValue, out);
+	}
+}
+
+void pid_batch_run(struct pid_batch *b, const int16_t *setPoint, const int16_t *processValue, size_t samples, int16_t *out) {
+	switch (b->isa) {
+		case PID_BATCH_AVX2:	avx2_run(b, setPoint, processValue, samples, out); break;
+		case PID_BATCH_SSE41:	sse41_run(b, setPoint, processValue, samples, out); break;
+		default:		scalar_run(b, 0, setPoint, processValue, samples, out);
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ * Batched evaluation of the PID controller on the host
+ *
+ * Runs the fixed-point algorithm of pid_controller() for many controllers
+ * at once. The states are kept as structure of arrays with one 32 bit lane
+ * per controller, so they can be processed by SSE4.1 (4 lanes) or AVX2
+ * (8 lanes). The results are bit-exact with pid_controller().
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#ifndef _PIDBATCH_H_
+#define _PIDBATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../pid.h"
+
+#define PID_BATCH_LANES 8 /* widest vector, arrays are padded to a multiple */
+
+enum pid_batch_isa {
+	PID_BATCH_SCALAR,
+	PID_BATCH_SSE41,
+	PID_BATCH_AVX2,
+	PID_BATCH_AUTO
+};
+
+/**
+ * States of many controllers, one entry of each array per controller
+ *
+ * All values are sign extended to 32 bit.
+ */
+struct pid_batch {
+	size_t count;
+
+	int32_t *lastProcessValue;
+	int32_t *sumError;
+	int32_t *pFactor;
+	int32_t *iFactor;
+	int32_t *dFactor;
+	int32_t *maxError;
+	int32_t *maxSumError;
+
+	enum pid_batch_isa isa;
+};
+
+/**
+ * Allocate a batch of count controllers
+ *
+ * All controllers are initialized like pid_init(0, 0, 0, ...).
+ *
+ * @return 0 on success
+ */
+int pid_batch_init(struct pid_batch *b, size_t count);
+void pid_batch_free(struct pid_batch *b);
+
+/**
+ * Select the instruction set
+ *
+ * @return The selected instruction set, PID_BATCH_AUTO picks the best one
+ *         supported by the CPU. Unsupported ones fall back to scalar code.
+ */
+enum pid_batch_isa pid_batch_select(struct pid_batch *b, enum pid_batch_isa isa);
+const char * pid_batch_name(enum pid_batch_isa isa);
+
+/**
+ * Copy the state of a controller initialized by pid_init() into lane i
+ */
+void pid_batch_load(struct pid_batch *b, size_t i, const struct pid *pid);
+void pid_batch_store(const struct pid_batch *b, size_t i, struct pid *pid);
+
+/**
+ * One step of all controllers
+ *
+ * out[i] = pid_controller(setPoint[i], processValue[i], controller i)
+ */
+void pid_batch_step(struct pid_batch *b, const int16_t *setPoint, const int16_t *processValue, int16_t *out);
+
+/**
+ * Feed the same recorded samples to all controllers
+ *
+ * Used to compare many gain sets against one recording. The states stay in
+ * registers for the whole recording.
+ *
+ * @param out	samples x count outputs (row per sample), may be NULL
+ */
+void pid_batch_run(struct pid_batch *b, const int16_t *setPoint, const int16_t *processValue, size_t samples, int16_t *out);
+
+#endif /* _PIDBATCH_H_ */
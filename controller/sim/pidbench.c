@@ -0,0 +1,297 @@
+/**
+ * Verification and benchmark of the batched PID controller
+ *
+ * Compares every instruction set of pidbatch.c against pid_controller()
+ * and measures the throughput in controller steps per second.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "../pid.h"
+#include "pidbatch.h"
+
+static uint32_t seed = 1;
+
+static uint32_t rnd() {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Random tuning constant, biased to edge cases and realistic values
+ */
+static int16_t factor() {
+	static const int16_t edges[] = { 0, 1, 2, 39, 127, 128, 255, 32767, -32768, -2, -128 };
+	int16_t f;
+
+	switch (rnd() % 4) {
+		case 0:
+			return edges[rnd() % (sizeof(edges) / sizeof(edges[0]))];
+
+		case 1:
+			return rnd() % 256;
+
+		default:
+			do f = rnd(); while (f == -1); /* pid_init() divides by f + 1 */
+			return f;
+	}
+}
+
+/**
+ * Random process value, biased to extremes
+ */
+static int16_t value() {
+	switch (rnd() % 4) {
+		case 0:
+			return (rnd() & 1) ? INT16_MAX : INT16_MIN;
+
+		case 1:
+			return (int16_t) (rnd() % 2048) - 1024;
+
+		default:
+			return rnd();
+	}
+}
+
+static void setup(struct pid *ref, struct pid_batch *b, size_t count) {
+	size_t k;
+
+	for (k = 0; k < count; k++) {
+		pid_init(factor(), factor(), factor(), &ref[k]);
+		pid_batch_load(b, k, &ref[k]);
+	}
+}
+
+static size_t compare(const struct pid *ref, const struct pid_batch *b, size_t count) {
+	struct pid pid;
+	size_t k, errors = 0;
+
+	for (k = 0; k < count; k++) {
+		pid_batch_store(b, k, &pid);
+
+		if (pid.lastProcessValue != ref[k].lastProcessValue || pid.sumError != ref[k].sumError)
+			errors++;
+	}
+
+	return errors;
+}
+
+/**
+ * @return Number of mismatching outputs and states
+ */
+static size_t verify(enum pid_batch_isa isa, size_t count, size_t steps) {
+	struct pid_batch b;
+	struct pid *ref = malloc(count * sizeof(struct pid));
+	int16_t *sp = malloc(steps * sizeof(int16_t));
+	int16_t *pv = malloc(steps * sizeof(int16_t));
+	int16_t *spk = malloc(count * sizeof(int16_t));
+	int16_t *pvk = malloc(count * sizeof(int16_t));
+	int16_t *out = malloc(steps * count * sizeof(int16_t));
+	size_t k, t, errors = 0;
+
+	if (!ref || !sp || !pv || !spk || !pvk || !out || pid_batch_init(&b, count)) {
+		perror("Failed to allocate memory");
+		exit(EXIT_FAILURE);
+	}
+
+	pid_batch_select(&b, isa);
+
+	/* independent inputs for every controller */
+	setup(ref, &b, count);
+	for (t = 0; t < steps; t++) {
+		for (k = 0; k < count; k++) {
+			spk[k] = value();
+			pvk[k] = value();
+		}
+
+		pid_batch_step(&b, spk, pvk, out);
+
+		for (k = 0; k < count; k++) {
+			if (out[k] != pid_controller(spk[k], pvk[k], &ref[k]))
+				errors++;
+		}
+	}
+
+	errors += compare(ref, &b, count);
+
+	/* one recording for all controllers */
+	setup(ref, &b, count);
+	for (t = 0; t < steps; t++) {
+		sp[t] = (rnd() % 8) ? 0 : value();
+		pv[t] = value();
+	}
+
+	pid_batch_run(&b, sp, pv, steps, out);
+
+	for (k = 0; k < count; k++) {
+		for (t = 0; t < steps; t++) {
+			if (out[t * count + k] != pid_controller(sp[t], pv[t], &ref[k]))
+				errors++;
+		}
+	}
+
+	errors += compare(ref, &b, count);
+
+	pid_batch_free(&b);
+	free(ref);
+	free(sp);
+	free(pv);
+	free(spk);
+	free(pvk);
+	free(out);
+
+	return errors;
+}
+
+static double bench_reference(size_t count, size_t samples, const int16_t *sp, const int16_t *pv) {
+	struct pid pid;
+	volatile int16_t sink;
+	double start = now();
+	size_t k, t;
+
+	for (k = 0; k < count; k++) {
+		pid_init(k % 256, k / 256, 0, &pid);
+
+		for (t = 0; t < samples; t++)
+			sink = pid_controller(sp[t], pv[t], &pid);
+	}
+
+	(void) sink;
+
+	return count * samples / (now() - start);
+}
+
+static double bench_batch(enum pid_batch_isa isa, size_t count, size_t samples, const int16_t *sp, const int16_t *pv, int16_t *out, size_t chunk) {
+	struct pid_batch b;
+	struct pid pid;
+	double start;
+	size_t k, t;
+
+	if (pid_batch_init(&b, count)) {
+		perror("Failed to allocate memory");
+		exit(EXIT_FAILURE);
+	}
+
+	pid_batch_select(&b, isa);
+
+	for (k = 0; k < count; k++) {
+		pid_init(k % 256, k / 256, 0, &pid);
+		pid_batch_load(&b, k, &pid);
+	}
+
+	start = now();
+
+	/* the outputs of a chunk are overwritten by the next one */
+	for (t = 0; t < samples; t += chunk)
+		pid_batch_run(&b, sp + t, pv + t, (samples - t < chunk) ? samples - t : chunk, out);
+
+	pid_batch_free(&b);
+
+	return count * samples / (now() - start);
+}
+
+static void usage(const char *name) {
+	printf("usage: %s [-v] [-c CONTROLLERS] [-n SAMPLES]\n", name);
+	printf("  -v             only verify against pid_controller()\n");
+	printf("  -c CONTROLLERS number of gain sets (default: 1024)\n");
+	printf("  -n SAMPLES     length of the recording (default: 100000)\n");
+}
+
+int main(int argc, char *argv[]) {
+	size_t count = 1024, samples = 100000, chunk = 64, t;
+	int c, verify_only = 0;
+	enum pid_batch_isa isa;
+	struct pid_batch probe;
+	int16_t *sp, *pv, *out;
+	size_t failed = 0;
+	double ref;
+
+	while ((c = getopt(argc, argv, "vc:n:h")) != -1) {
+		switch (c) {
+			case 'v': verify_only = 1; break;
+			case 'c': count = atoi(optarg); break;
+			case 'n': samples = atoi(optarg); break;
+			default:
+				usage(argv[0]);
+				exit((c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	pid_batch_init(&probe, 1);
+
+	/* odd counts exercise the scalar tails of the vector kernels */
+	for (isa = PID_BATCH_SCALAR; isa < PID_BATCH_AUTO; isa++) {
+		size_t errors;
+
+		if (pid_batch_select(&probe, isa) != isa) {
+			printf("verify %-7s unsupported\n", pid_batch_name(isa));
+			continue;
+		}
+
+		errors = verify(isa, 1003, 2000) + verify(isa, 5, 2000);
+		printf("verify %-7s %s (%zu mismatches)\n", pid_batch_name(isa), errors ? "FAILED" : "ok", errors);
+		failed += errors;
+	}
+
+	if (verify_only || failed)
+		return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+	sp = malloc(samples * sizeof(int16_t));
+	pv = malloc(samples * sizeof(int16_t));
+	out = malloc(chunk * count * sizeof(int16_t));
+	if (!sp || !pv || !out) {
+		perror("Failed to allocate memory");
+		exit(EXIT_FAILURE);
+	}
+
+	/* a recording of the inductor difference around the wire */
+	for (t = 0; t < samples; t++) {
+		sp[t] = 0;
+		pv[t] = (int16_t) (rnd() % 400) - 200;
+	}
+
+	printf("\n%zu controllers x %zu samples\n", count, samples);
+
+	ref = bench_reference(count / 16 ? count / 16 : 1, samples, sp, pv);
+	printf("%-16s %8.1f M steps/s\n", "pid_controller", ref / 1e6);
+
+	for (isa = PID_BATCH_SCALAR; isa < PID_BATCH_AUTO; isa++) {
+		double rate;
+
+		if (pid_batch_select(&probe, isa) != isa)
+			continue;
+
+		rate = bench_batch(isa, count, samples, sp, pv, out, chunk);
+		printf("batch %-10s %8.1f M steps/s (%.1fx)\n", pid_batch_name(isa), rate / 1e6, rate / ref);
+
+		rate = bench_batch(isa, count, samples, sp, pv, NULL, chunk);
+		printf("batch %-10s %8.1f M steps/s (%.1fx, without outputs)\n", pid_batch_name(isa), rate / 1e6, rate / ref);
+	}
+
+	pid_batch_free(&probe);
+	free(sp);
+	free(pv);
+	free(out);
+
+	return EXIT_SUCCESS;
+}
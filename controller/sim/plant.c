@@ -0,0 +1,85 @@
+/**
+ * Vehicle and track model for the host simulation
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#include <math.h>
+
+#include "plant.h"
+
+void plant_init(struct plant *p) {
+	p->s = 0;
+	p->y = 0;
+	p->psi = 0;
+	p->v = 0;
+	p->delta = 0;
+	p->distance = 0;
+	p->seed = 1;
+	p->noise = 4;
+}
+
+double plant_lap() {
+	return 2 * PLANT_STRAIGHT + 2 * M_PI * PLANT_RADIUS;
+}
+
+double plant_curvature(double s) {
+	double curve = M_PI * PLANT_RADIUS;
+
+	s = fmod(s, plant_lap());
+
+	if (s < PLANT_STRAIGHT)
+		return 0;
+	else if (s < PLANT_STRAIGHT + curve)
+		return 1 / PLANT_RADIUS;
+	else if (s < 2 * PLANT_STRAIGHT + curve)
+		return 0;
+	else
+		return 1 / PLANT_RADIUS;
+}
+
+void plant_step(struct plant *p, double dt, double stering, double drive) {
+	double kappa = plant_curvature(p->s);
+	double delta = stering * PLANT_STERING_MAX - p->delta;
+	double ds;
+
+	/* the servo turns with limited speed */
+	if (delta > PLANT_SERVO_RATE * dt)
+		delta = PLANT_SERVO_RATE * dt;
+	else if (delta < -PLANT_SERVO_RATE * dt)
+		delta = -PLANT_SERVO_RATE * dt;
+
+	p->delta += delta;
+	p->v += (drive * PLANT_SPEED_MAX - p->v) * dt / PLANT_TAU;
+
+	/* movement relative to the track (Frenet frame) */
+	ds = p->v * cos(p->psi) / (1 - p->y * kappa);
+	p->psi += (p->v * tan(p->delta) / PLANT_WHEELBASE - kappa * ds) * dt;
+	p->y += p->v * sin(p->psi) * dt;
+	p->s += ds * dt;
+
+	p->distance += p->v * dt;
+}
+
+uint16_t plant_inductor(struct plant *p, enum plant_inductor side) {
+	double h2 = PLANT_HEIGHT * PLANT_HEIGHT;
+	double y = p->y + PLANT_LOOKAHEAD * sin(p->psi);
+	double field;
+	int32_t counts;
+
+	y += (side == PLANT_LEFT) ? PLANT_SPACING : -PLANT_SPACING;
+	field = PLANT_ADC_PEAK * h2 / (h2 + y * y);
+
+	/* linear congruential generator, uniform noise */
+	p->seed = p->seed * 1103515245 + 12345;
+	counts = field + 0.5;
+	if (p->noise)
+		counts += (int32_t) ((p->seed >> 16) % (p->noise + 1)) - p->noise / 2;
+
+	if (counts < 0) counts = 0;
+	if (counts > 1023) counts = 1023;
+
+	return counts;
+}
@@ -0,0 +1,74 @@
+/**
+ * Vehicle and track model for the host simulation
+ *
+ * Kinematic single track model of the car following a wire on an oval
+ * track. Both steering inductors are modeled by the field of an infinite
+ * straight conductor.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#ifndef _PLANT_H_
+#define _PLANT_H_
+
+#include <stdint.h>
+
+#define PLANT_WHEELBASE		0.20	/* m */
+#define PLANT_STERING_MAX	0.50	/* rad at full servo deflection */
+#define PLANT_SERVO_RATE	5.20	/* rad/s, 0.2 s per 60 degrees */
+#define PLANT_SPEED_MAX		2.50	/* m/s at full motor PWM */
+#define PLANT_TAU		0.30	/* s, motor time constant */
+
+#define PLANT_LOOKAHEAD		0.10	/* m, inductors in front of the rear axle */
+#define PLANT_SPACING		0.04	/* m, lateral offset of each inductor */
+#define PLANT_HEIGHT		0.03	/* m, above the wire */
+#define PLANT_ADC_PEAK		1000.0	/* ADC counts right above the wire */
+
+#define PLANT_STRAIGHT		2.00	/* m */
+#define PLANT_RADIUS		0.80	/* m */
+
+#define PLANT_BATT_LOGIC	800	/* ADC counts */
+#define PLANT_BATT_DRIVE	700
+
+enum plant_inductor {
+	PLANT_LEFT,
+	PLANT_RIGHT
+};
+
+struct plant {
+	double s;	/* m, distance along the track */
+	double y;	/* m, lateral offset, positive is left of the wire */
+	double psi;	/* rad, heading relative to the track */
+	double v;	/* m/s */
+	double delta;	/* rad, actual stering angle */
+
+	double distance;	/* m, travelled in total */
+	uint32_t seed;		/* sensor noise */
+	uint16_t noise;		/* ADC counts peak to peak */
+};
+
+void plant_init(struct plant *p);
+
+/**
+ * Integrate the model
+ *
+ * @param stering	-1 (right) .. 1 (left)
+ * @param drive		0 .. 1
+ */
+void plant_step(struct plant *p, double dt, double stering, double drive);
+
+/**
+ * Curvature of the track at position s (positive is a left turn)
+ */
+double plant_curvature(double s);
+
+/**
+ * Length of a single lap
+ */
+double plant_lap();
+
+uint16_t plant_inductor(struct plant *p, enum plant_inductor side);
+
+#endif /* _PLANT_H_ */
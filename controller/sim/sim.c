@@ -0,0 +1,571 @@
+/**
+ * Host simulation of the firmware
+ *
+ * Runs the unmodified controller code on Linux against simulated
+ * peripherals and the vehicle model of plant.c. The simulated clock only
+ * advances by register accesses and busy waiting of the firmware, so the
+ * simulation runs as fast as the host allows and is fully deterministic.
+ *
+ * The UART is connected to a pseudo terminal. Its name is printed at startup
+ * and can be opened by the frontend like a real serial port.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <termios.h>
+
+#include "avr/io.h"
+#include "avr/interrupt.h"
+
+#include "sim.h"
+#include "plant.h"
+
+#define NEVER		UINT64_MAX
+#define CYCLES(s)	((uint64_t) ((s) * F_CPU))
+#define SECONDS(c)	((double) (c) / F_CPU)
+
+#define PLANT_STEP	CYCLES(1e-3)	/* s */
+#define RX_POLL		CYCLES(1e-3)	/* s */
+#define PULSE_DISTANCE	0.01		/* m per pulse of the speed sensor */
+#define TX_BUFFER	4096
+
+/* firmware */
+int controller_main();
+
+extern int16_t pwm_drive_ee;
+extern int16_t pid_stering_p_ee;
+extern int16_t pid_stering_i_ee;
+
+/* interrupt sources, highest priority first */
+enum irq {
+	IRQ_INT0,
+	IRQ_TIMER2,
+	IRQ_TIMER1,
+	IRQ_TIMER0,
+	IRQ_RXC,
+	IRQ_UDRE,
+	IRQ_ADC
+};
+
+enum event {
+	EV_TIMER0,
+	EV_TIMER1,
+	EV_TIMER2,
+	EV_ADC,
+	EV_TX,
+	EV_RX,
+	EV_PULSE,
+	EV_PLANT,
+	EVENTS
+};
+
+/* a press of one of the extra buttons */
+struct press {
+	double start, duration;
+	uint8_t pin;
+};
+
+static volatile uint8_t io8[0x41];
+static volatile uint16_t io16[0x40];
+
+static uint64_t now;
+static uint64_t next[EVENTS];
+
+static bool enabled;		/* global interrupt flag */
+static bool in_isr;		/* interrupts do not nest and take no time */
+static uint8_t pending;		/* edge triggered interrupts, bit per enum irq */
+
+static bool tx_busy;
+static uint8_t rx_data;
+
+static struct plant plant;
+
+static int pty = -1;
+static unsigned char tx_buf[TX_BUFFER];
+static size_t tx_len;
+static unsigned char rx_buf[256];
+static size_t rx_len, rx_pos;
+
+static double duration;		/* simulated seconds, 0 = forever */
+static double factor;		/* realtime factor, 0 = as fast as possible */
+static struct timespec start;
+
+static struct press script[2];
+static unsigned presses;
+
+static struct {
+	uint64_t tx_bytes, tx_dropped, rx_bytes;
+	uint64_t irqs, pulses;
+	double error_sum, error_max;
+	uint64_t steps;
+} stats;
+
+static const char *slave;
+static const char *link_path;
+
+volatile uint8_t * sim_io8(uint8_t addr) {
+	if (!in_isr)
+		sim_advance(SIM_ACCESS_CYCLES);
+
+	return &io8[addr];
+}
+
+volatile uint16_t * sim_io16(uint8_t addr) {
+	if (!in_isr)
+		sim_advance(SIM_ACCESS_CYCLES);
+
+	return &io16[addr];
+}
+
+static double wall() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec - start.tv_sec) + (ts.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * Prescaler of timer 0 and 1 (CSx2..0)
+ */
+static unsigned prescaler01(uint8_t cs) {
+	static const unsigned table[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+	return table[cs & 0x7]; /* external clock sources are not simulated */
+}
+
+static unsigned prescaler2(uint8_t cs) {
+	static const unsigned table[] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+	return table[cs & 0x7];
+}
+
+static uint64_t period(enum event ev) {
+	switch (ev) {
+		case EV_TIMER0:
+			return 256ULL * prescaler01(io8[0x33]);
+
+		case EV_TIMER1: {
+			/* fast PWM with ICR1 as TOP (mode 14) or normal mode */
+			bool icr = (io8[0x2F] & 0x03) == (1<<WGM11) && (io8[0x2E] & 0x18) == ((1<<WGM13) | (1<<WGM12));
+			uint32_t top = icr ? io16[0x26] : 0xffff;
+
+			return (top + 1ULL) * prescaler01(io8[0x2E]);
+		}
+
+		case EV_TIMER2:
+			return 256ULL * prescaler2(io8[0x25]);
+
+		case EV_ADC:
+			/* 13 ADC clock cycles per conversion */
+			return 13ULL << ((io8[0x06] & 0x7) ? (io8[0x06] & 0x7) : 1);
+
+		case EV_TX: {
+			unsigned ubrr = ((io8[0x20] & 0x0f) << 8) | io8[0x09];
+			unsigned div = (io8[0x0B] & (1<<U2X)) ? 8 : 16;
+
+			return 10ULL * div * (ubrr + 1); /* 8N1 */
+		}
+
+		default:
+			return NEVER;
+	}
+}
+
+/**
+ * Arm the events which depend on the state of the registers
+ */
+static void schedule() {
+	int i;
+
+	for (i = EV_TIMER0; i <= EV_TIMER2; i++) {
+		uint64_t p = period(i);
+
+		if (p == 0)
+			next[i] = NEVER;
+		else if (next[i] == NEVER)
+			next[i] = now + p;
+	}
+
+	if ((io8[0x06] & (1<<ADEN)) && (io8[0x06] & (1<<ADSC)) && next[EV_ADC] == NEVER)
+		next[EV_ADC] = now + period(EV_ADC);
+}
+
+static void tx_flush() {
+	size_t pos = 0;
+
+	while (pos < tx_len) {
+		ssize_t ret = write(pty, tx_buf + pos, tx_len - pos);
+		if (ret < 0) {
+			if (errno != EAGAIN) {
+				perror("Failed to write to pty");
+				exit(EXIT_FAILURE);
+			}
+
+			/* nobody is reading, drop the rest like a disconnected cable */
+			stats.tx_dropped += tx_len - pos;
+			break;
+		}
+
+		pos += ret;
+	}
+
+	stats.tx_bytes += tx_len;
+	tx_len = 0;
+}
+
+static bool udre() {
+	return (io8[0x0A] & (1<<UDRIE)) && (io8[0x0A] & (1<<TXEN)) && !tx_busy;
+}
+
+/**
+ * Call pending ISRs by priority
+ */
+static void dispatch() {
+	if (!enabled || in_isr)
+		return;
+
+	for (;;) {
+		enum irq irq;
+
+		for (irq = IRQ_INT0; irq <= IRQ_ADC; irq++) {
+			if (irq == IRQ_UDRE ? udre() : (pending & (1 << irq)))
+				break;
+		}
+
+		if (irq > IRQ_ADC)
+			return;
+
+		pending &= ~(1 << irq);
+		stats.irqs++;
+		in_isr = true;
+
+		switch (irq) {
+			case IRQ_INT0:		INT0_vect(); break;
+			case IRQ_TIMER2:	TIMER2_OVF_vect(); break;
+			case IRQ_TIMER1:	TIMER1_OVF_vect(); break;
+			case IRQ_TIMER0:	TIMER0_OVF_vect(); break;
+
+			case IRQ_RXC:
+				io8[0x0C] = rx_data;
+				io8[0x0B] &= ~(1<<RXC);
+				USART_RXC_vect();
+				break;
+
+			case IRQ_UDRE:
+				USART_UDRE_vect();
+
+				/* the ISR either wrote UDR or disabled UDRIE */
+				if (io8[0x0A] & (1<<UDRIE)) {
+					tx_buf[tx_len++] = io8[0x0C];
+					if (tx_len == TX_BUFFER)
+						tx_flush();
+
+					tx_busy = true;
+					next[EV_TX] = now + period(EV_TX);
+				}
+				break;
+
+			case IRQ_ADC:
+				io8[0x06] &= ~(1<<ADIF);
+				ADC_vect();
+				break;
+		}
+
+		in_isr = false;
+	}
+}
+
+static void rx_poll() {
+	if (rx_pos == rx_len) {
+		ssize_t ret = read(pty, rx_buf, sizeof(rx_buf));
+
+		rx_pos = 0;
+		rx_len = (ret > 0) ? ret : 0;
+	}
+
+	if (rx_pos < rx_len && (io8[0x0A] & (1<<RXEN))) {
+		rx_data = rx_buf[rx_pos++];
+		stats.rx_bytes++;
+
+		if (io8[0x0B] & (1<<RXC))
+			io8[0x0B] |= (1<<DOR);
+
+		io8[0x0B] |= (1<<RXC);
+		if (io8[0x0A] & (1<<RXCIE))
+			pending |= (1 << IRQ_RXC);
+	}
+
+	next[EV_RX] = now + ((rx_pos < rx_len) ? period(EV_TX) : RX_POLL);
+}
+
+static void buttons() {
+	double t = SECONDS(now);
+	uint8_t pinb = 0xff; /* pull ups */
+	unsigned i;
+
+	for (i = 0; i < presses; i++) {
+		if (t >= script[i].start && t < script[i].start + script[i].duration)
+			pinb &= ~(1 << script[i].pin);
+	}
+
+	io8[0x16] = pinb;
+}
+
+static void report() {
+	double t = SECONDS(now), w = wall();
+
+	tx_flush();
+
+	printf("simulated %.3f s in %.3f s wall time (%.1fx realtime)\n", t, w, t / w);
+	printf("  distance:   %.2f m (%.2f laps), speed %.2f m/s\n", plant.distance, plant.distance / plant_lap(), plant.v);
+	printf("  lateral:    %.1f mm mean, %.1f mm max\n",
+		stats.steps ? 1e3 * stats.error_sum / stats.steps : 0, 1e3 * stats.error_max);
+	printf("  interrupts: %llu, speed pulses: %llu\n", (unsigned long long) stats.irqs, (unsigned long long) stats.pulses);
+	printf("  uart:       %llu bytes sent (%llu dropped), %llu received\n",
+		(unsigned long long) stats.tx_bytes, (unsigned long long) stats.tx_dropped, (unsigned long long) stats.rx_bytes);
+}
+
+static void plant_update() {
+	uint16_t ocr1a = io16[0x2A];
+	double stering = ocr1a ? (ocr1a - 3000) / 1200.0 : 0; /* no servo pulses => straight */
+	double drive = io8[0x23] / 255.0;
+	double error = fabs(plant.y);
+
+	/* the motor PWM only drives while timer 2 is running */
+	if (!prescaler2(io8[0x25]))
+		drive = 0;
+
+	plant_step(&plant, SECONDS(PLANT_STEP), stering, drive);
+	buttons();
+
+	stats.steps++;
+	stats.error_sum += error;
+	if (error > stats.error_max)
+		stats.error_max = error;
+
+	/* speed sensor: INT0 on every PULSE_DISTANCE */
+	if (next[EV_PULSE] == NEVER && plant.v > 1e-3)
+		next[EV_PULSE] = now + CYCLES(PULSE_DISTANCE / plant.v);
+
+	tx_flush();
+
+	if (duration && SECONDS(now) >= duration) {
+		report();
+		exit(EXIT_SUCCESS);
+	}
+
+	if (factor) {
+		double ahead = SECONDS(now) / factor - wall();
+
+		if (ahead > 1e-3) {
+			struct timespec ts = { 0, ahead * 1e9 };
+			nanosleep(&ts, NULL);
+		}
+	}
+
+	next[EV_PLANT] = now + PLANT_STEP;
+}
+
+static void handle(enum event ev) {
+	switch (ev) {
+		case EV_TIMER0:
+		case EV_TIMER1:
+		case EV_TIMER2: {
+			static const uint8_t toie[] = { TOIE0, TOIE1, TOIE2 };
+			static const enum irq irq[] = { IRQ_TIMER0, IRQ_TIMER1, IRQ_TIMER2 };
+
+			if (io8[0x39] & (1 << toie[ev - EV_TIMER0]))
+				pending |= 1 << irq[ev - EV_TIMER0];
+
+			next[ev] = now + period(ev);
+			break;
+		}
+
+		case EV_ADC: {
+			uint8_t ch = io8[0x07] & 0x1F;
+
+			switch (ch) {
+				case 0: io16[0x04] = plant_inductor(&plant, PLANT_LEFT); break;
+				case 1: io16[0x04] = plant_inductor(&plant, PLANT_RIGHT); break;
+				case 2: io16[0x04] = PLANT_BATT_LOGIC; break;
+				case 3: io16[0x04] = PLANT_BATT_DRIVE; break;
+				default: io16[0x04] = 0;
+			}
+
+			io8[0x06] &= ~(1<<ADSC);
+			io8[0x06] |= (1<<ADIF);
+			if (io8[0x06] & (1<<ADIE))
+				pending |= 1 << IRQ_ADC;
+
+			next[ev] = NEVER;
+			break;
+		}
+
+		case EV_TX:
+			tx_busy = false;
+			next[ev] = NEVER;
+			break;
+
+		case EV_RX:
+			rx_poll();
+			break;
+
+		case EV_PULSE:
+			stats.pulses++;
+			if (io8[0x3B] & (1<<INT0))
+				pending |= 1 << IRQ_INT0;
+
+			next[ev] = (plant.v > 1e-3) ? now + CYCLES(PULSE_DISTANCE / plant.v) : NEVER;
+			break;
+
+		case EV_PLANT:
+			plant_update();
+			break;
+
+		default:
+			break;
+	}
+}
+
+void sim_advance(uint64_t cycles) {
+	uint64_t target = now + cycles;
+
+	for (;;) {
+		enum event ev, first = EV_TIMER0;
+
+		schedule();
+
+		for (ev = EV_TIMER0; ev < EVENTS; ev++) {
+			if (next[ev] < next[first])
+				first = ev;
+		}
+
+		if (next[first] > target)
+			break;
+
+		now = next[first];
+		handle(first);
+		dispatch();
+	}
+
+	now = target;
+	dispatch();
+}
+
+void sim_delay_us(double us) {
+	if (!in_isr)
+		sim_advance(CYCLES(us / 1e6));
+}
+
+void sim_sei() {
+	enabled = true;
+	dispatch();
+}
+
+void sim_cli() {
+	enabled = false;
+}
+
+static void pty_open() {
+	struct termios tio;
+	int fd;
+
+	pty = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (pty < 0 || grantpt(pty) || unlockpt(pty)) {
+		perror("Failed to create pty");
+		exit(EXIT_FAILURE);
+	}
+
+	slave = ptsname(pty);
+
+	/* keep the slave open in raw mode: no echo and no EIO without reader */
+	fd = open(slave, O_RDWR | O_NOCTTY);
+	if (fd < 0 || tcgetattr(fd, &tio)) {
+		perror("Failed to open pty slave");
+		exit(EXIT_FAILURE);
+	}
+
+	cfmakeraw(&tio);
+	tcsetattr(fd, TCSANOW, &tio);
+
+	if (link_path) {
+		unlink(link_path);
+		if (symlink(slave, link_path)) {
+			perror("Failed to link pty");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+static void usage(const char *name) {
+	printf("usage: %s [-t SECONDS] [-r FACTOR] [-l LINK] [-a] [-d PWM] [-P FACTOR] [-I FACTOR]\n", name);
+	printf("  -t SECONDS  stop after simulated time (default: run forever)\n");
+	printf("  -r FACTOR   pace simulated time to FACTOR x realtime (default: as fast as possible)\n");
+	printf("  -l LINK     create a symlink to the pty\n");
+	printf("  -a          switch to AUTO mode by pressing the green button twice\n");
+	printf("  -d PWM      motor PWM in EEPROM (pwm_drive)\n");
+	printf("  -P FACTOR   proportional factor of the stering controller in EEPROM\n");
+	printf("  -I FACTOR   integral factor of the stering controller in EEPROM\n");
+}
+
+int main(int argc, char *argv[]) {
+	int c, i;
+
+	while ((c = getopt(argc, argv, "t:r:l:ad:P:I:h")) != -1) {
+		switch (c) {
+			case 't': duration = atof(optarg); break;
+			case 'r': factor = atof(optarg); break;
+			case 'l': link_path = optarg; break;
+			case 'd': pwm_drive_ee = atoi(optarg); break;
+			case 'P': pid_stering_p_ee = atoi(optarg); break;
+			case 'I': pid_stering_i_ee = atoi(optarg); break;
+
+			case 'a': {
+				/* HALT => MANUAL => AUTO, after the greeter */
+				struct press first = { 2.0, 0.1, PB4 }, second = { 2.5, 0.1, PB4 };
+
+				script[0] = first;
+				script[1] = second;
+				presses = 2;
+				break;
+			}
+
+			default:
+				usage(argv[0]);
+				exit((c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	for (i = 0; i < EVENTS; i++)
+		next[i] = NEVER;
+	next[EV_PLANT] = PLANT_STEP;
+	next[EV_RX] = RX_POLL;
+
+	io8[0x0B] = (1<<UDRE);
+	io8[0x16] = 0xff;
+
+	plant_init(&plant);
+	pty_open();
+
+	printf("pty: %s\n", slave);
+	fflush(stdout);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	return controller_main();
+}
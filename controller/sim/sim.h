@@ -0,0 +1,33 @@
+/**
+ * Host simulation of the ATmega32 peripherals used by the firmware
+ *
+ * All I/O registers are accessed through sim_io8() and sim_io16(). Every
+ * access from the main context advances the simulated clock by a few cycles,
+ * so busy-waiting loops terminate. Timers, ADC, UART and the speed sensor are
+ * driven by the simulated clock and call the ISRs of the firmware.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+#define SIM_ACCESS_CYCLES 2	/* simulated cycles per register access */
+
+volatile uint8_t * sim_io8(uint8_t addr);
+volatile uint16_t * sim_io16(uint8_t addr);
+
+/**
+ * Let simulated time pass, processes peripherals and interrupts
+ */
+void sim_advance(uint64_t cycles);
+void sim_delay_us(double us);
+
+void sim_sei(void);
+void sim_cli(void);
+
+#endif /* _SIM_H_ */
@@ -0,0 +1,333 @@
+/**
+ * Parallel auto-tuner for the stering controller
+ *
+ * Runs pid_controller() in closed loop with the vehicle and track model of
+ * plant.c for every candidate gain set and ranks them by lateral error and
+ * track-loss events. The candidates are split among worker threads which
+ * steal half of the remaining work of another thread when they run dry.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../pid.h"
+#include "plant.h"
+
+#define CONTROL_RATE	(16e6 / 64 / 256)	/* Timer 2 overflows, see init() */
+#define LOSS_THRESHOLD	30			/* sum of both inductors, see TIMER2_OVF_vect */
+#define LOSS_PENALTY	1.0			/* m of RMS error per track-loss event */
+#define BATCH		4			/* candidates taken at once */
+
+struct range {
+	int from, to, step;
+};
+
+struct candidate {
+	int16_t p, i, d;
+
+	double rms;		/* m, lateral error */
+	double max;		/* m */
+	unsigned losses;	/* track-loss events */
+	double cost;
+};
+
+/**
+ * Work queue of a thread: candidates [head, tail)
+ */
+struct worker {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	size_t head, tail;
+
+	size_t done, stolen;
+};
+
+static struct candidate *candidates;
+static struct worker *workers;
+static unsigned threads;
+
+static double duration = 20;	/* simulated seconds per candidate */
+static int16_t pwm_drive = 100;
+static unsigned max_losses = 10;
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Closed loop with the control law of TIMER2_OVF_vect in AUTO mode
+ *
+ * On track loss the firmware halts. Here the car is put back on the wire
+ * instead, so the number of events is meaningful.
+ */
+static void evaluate(struct candidate *c) {
+	struct plant plant;
+	struct pid pid;
+	double dt = 1 / CONTROL_RATE, sq = 0;
+	unsigned long steps = duration * CONTROL_RATE, n;
+
+	plant_init(&plant);
+	pid_init(c->p, c->i, c->d, &pid);
+
+	c->max = 0;
+	c->losses = 0;
+
+	for (n = 0; n < steps && c->losses < max_losses; n++) {
+		int16_t left = plant_inductor(&plant, PLANT_LEFT);
+		int16_t right = plant_inductor(&plant, PLANT_RIGHT);
+		int16_t diff = right - left;
+		uint16_t sum = right + left;
+		int8_t out_stering;
+		uint8_t out_drive;
+		double error;
+
+		if (sum < LOSS_THRESHOLD) {
+			c->losses++;
+
+			plant.y = 0;
+			plant.psi = 0;
+			plant.v = 0;
+			pid_reset_integrator(&pid);
+			continue;
+		}
+
+		out_stering = pid_controller(0, diff, &pid);
+		out_drive = (pwm_drive>>1) + (( pwm_drive * (128 - abs(out_stering))) >> 8);
+
+		/* OCR1A = 3000 + 9 * out_stering, see plant_update() in sim.c */
+		plant_step(&plant, dt, out_stering * 9 / 1200.0, out_drive / 255.0);
+
+		error = fabs(plant.y);
+		sq += error * error;
+		if (error > c->max)
+			c->max = error;
+	}
+
+	c->rms = sqrt(sq / n);
+	c->cost = c->rms + LOSS_PENALTY * c->losses;
+}
+
+/**
+ * Take the next candidates from the own queue
+ *
+ * @return Number of candidates, starting at *first
+ */
+static size_t take(struct worker *w, size_t *first) {
+	size_t n;
+
+	pthread_mutex_lock(&w->lock);
+
+	n = w->tail - w->head;
+	if (n > BATCH) n = BATCH;
+
+	*first = w->head;
+	w->head += n;
+
+	pthread_mutex_unlock(&w->lock);
+
+	return n;
+}
+
+/**
+ * Move the upper half of the largest other queue to w
+ */
+static int steal(struct worker *w) {
+	struct worker *victim = NULL;
+	size_t best = 0, half;
+	unsigned k;
+
+	/* unlocked peek, the victim is locked before taking anything */
+	for (k = 0; k < threads; k++) {
+		size_t left = workers[k].tail - workers[k].head;
+
+		if (&workers[k] != w && left > best) {
+			best = left;
+			victim = &workers[k];
+		}
+	}
+
+	if (!victim)
+		return 0;
+
+	pthread_mutex_lock(&victim->lock);
+
+	half = (victim->tail - victim->head + 1) / 2;
+	if (half) {
+		pthread_mutex_lock(&w->lock);
+		w->tail = victim->tail;
+		w->head = victim->tail - half;
+		pthread_mutex_unlock(&w->lock);
+
+		victim->tail -= half;
+		w->stolen += half;
+	}
+
+	pthread_mutex_unlock(&victim->lock);
+
+	return 1; /* a victim existed, maybe others still have work */
+}
+
+static void * work(void *arg) {
+	struct worker *w = arg;
+	size_t first, n, k;
+
+	for (;;) {
+		while ((n = take(w, &first))) {
+			for (k = first; k < first + n; k++)
+				evaluate(&candidates[k]);
+
+			w->done += n;
+		}
+
+		if (!steal(w))
+			break;
+	}
+
+	return NULL;
+}
+
+static int compare(const void *a, const void *b) {
+	const struct candidate *ca = a, *cb = b;
+
+	return (ca->cost > cb->cost) - (ca->cost < cb->cost);
+}
+
+static struct range parse(const char *arg) {
+	struct range r = { 0, 0, 1 };
+
+	switch (sscanf(arg, "%d:%d:%d", &r.from, &r.to, &r.step)) {
+		case 1:
+			r.to = r.from;
+			break;
+
+		case 2:
+		case 3:
+			if (r.step > 0)
+				break;
+
+		default:
+			fprintf(stderr, "Invalid range: %s\n", arg);
+			exit(EXIT_FAILURE);
+	}
+
+	return r;
+}
+
+static size_t steps(struct range r) {
+	return (r.to >= r.from) ? (r.to - r.from) / r.step + 1 : 0;
+}
+
+static void usage(const char *name) {
+	printf("usage: %s [-p RANGE] [-i RANGE] [-d RANGE] [-t SECONDS] [-w PWM] [-j THREADS] [-n TOP]\n", name);
+	printf("  RANGE is FROM[:TO[:STEP]] of a tuning constant (x%d)\n", SCALING_FACTOR);
+	printf("  -p RANGE    proportional factor (default: 0:255)\n");
+	printf("  -i RANGE    integral factor (default: 0:8)\n");
+	printf("  -d RANGE    derivative factor (default: 0:64:4)\n");
+	printf("  -t SECONDS  simulated time per candidate (default: %.0f)\n", duration);
+	printf("  -w PWM      motor PWM as pwm_drive (default: %d)\n", pwm_drive);
+	printf("  -j THREADS  worker threads (default: number of cores)\n");
+	printf("  -n TOP      number of reported candidates (default: 10)\n");
+}
+
+int main(int argc, char *argv[]) {
+	struct range p = { 0, 255, 1 }, i = { 0, 8, 1 }, d = { 0, 64, 4 };
+	size_t count, k, top = 10, stolen = 0;
+	double start, elapsed;
+	int c, ip, ii, id;
+
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((c = getopt(argc, argv, "p:i:d:t:w:j:n:h")) != -1) {
+		switch (c) {
+			case 'p': p = parse(optarg); break;
+			case 'i': i = parse(optarg); break;
+			case 'd': d = parse(optarg); break;
+			case 't': duration = atof(optarg); break;
+			case 'w': pwm_drive = atoi(optarg); break;
+			case 'j': threads = atoi(optarg); break;
+			case 'n': top = atoi(optarg); break;
+			default:
+				usage(argv[0]);
+				exit((c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	if (threads < 1)
+		threads = 1;
+
+	count = steps(p) * steps(i) * steps(d);
+	candidates = malloc(count * sizeof(struct candidate));
+	workers = calloc(threads, sizeof(struct worker));
+	if (!candidates || !workers) {
+		perror("Failed to allocate memory");
+		exit(EXIT_FAILURE);
+	}
+
+	k = 0;
+	for (ip = p.from; ip <= p.to; ip += p.step) {
+		for (ii = i.from; ii <= i.to; ii += i.step) {
+			for (id = d.from; id <= d.to; id += d.step) {
+				candidates[k].p = ip;
+				candidates[k].i = ii;
+				candidates[k].d = id;
+				k++;
+			}
+		}
+	}
+
+	printf("%zu candidates, %.0f s each at pwm_drive %d, %u threads\n", count, duration, pwm_drive, threads);
+
+	/* equal shares, neighbouring candidates take similar time */
+	for (k = 0; k < threads; k++) {
+		pthread_mutex_init(&workers[k].lock, NULL);
+		workers[k].head = count * k / threads;
+		workers[k].tail = count * (k + 1) / threads;
+	}
+
+	start = now();
+
+	for (k = 0; k < threads; k++) {
+		if (pthread_create(&workers[k].thread, NULL, work, &workers[k])) {
+			perror("Failed to create thread");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (k = 0; k < threads; k++) {
+		pthread_join(workers[k].thread, NULL);
+		pthread_mutex_destroy(&workers[k].lock);
+		stolen += workers[k].stolen;
+	}
+
+	elapsed = now() - start;
+
+	qsort(candidates, count, sizeof(struct candidate), compare);
+
+	printf("%.2f s, %.0f candidates/min, %zu stolen\n\n", elapsed, count / elapsed * 60, stolen);
+	printf("%6s %6s %6s %10s %10s %7s\n", "P", "I", "D", "rms [mm]", "max [mm]", "losses");
+
+	for (k = 0; k < top && k < count; k++) {
+		struct candidate *c = &candidates[k];
+
+		printf("%6d %6d %6d %10.2f %10.2f %7u\n", c->p, c->i, c->d, 1e3 * c->rms, 1e3 * c->max, c->losses);
+	}
+
+	free(candidates);
+	free(workers);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,13 @@
+/**
+ * Simulated busy waiting: advances the simulated clock
+ */
+
+#ifndef _UTIL_DELAY_H_
+#define _UTIL_DELAY_H_
+
+#include "../sim.h"
+
+#define _delay_us(us)	sim_delay_us(us)
+#define _delay_ms(ms)	sim_delay_us((ms) * 1000.0)
+
+#endif /* _UTIL_DELAY_H_ */
@@ -0,0 +1,106 @@
+/**
+ * Binary telemetry frames
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#include "telemetry.h"
+
+uint8_t telemetry_crc8(const uint8_t *data, uint8_t len) {
+	uint8_t crc = 0;
+
+	while (len--) {
+		crc ^= *data++;
+
+		for (uint8_t i = 0; i < 8; i++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+void telemetry_pack(uint8_t *p, const struct telemetry *t) {
+	const uint16_t *adc = t->adc;
+
+	p[0] = t->seq;
+	p[1] = t->tick;
+	p[2] = t->tick >> 8;
+
+	// 4 x 10 bit in 5 byte
+	p[3] = adc[0];
+	p[4] = ((adc[0] >> 8) & 0x03) | (adc[1] << 2);
+	p[5] = ((adc[1] >> 6) & 0x0f) | (adc[2] << 4);
+	p[6] = ((adc[2] >> 4) & 0x3f) | (adc[3] << 6);
+	p[7] = adc[3] >> 2;
+
+	p[8] = t->speed;
+	p[9] = t->out_stering;
+	p[10] = t->out_drive;
+
+	p[11] = telemetry_crc8(p, TELEMETRY_PAYLOAD_LEN - 1);
+}
+
+int8_t telemetry_unpack(struct telemetry *t, const uint8_t *p) {
+	if (telemetry_crc8(p, TELEMETRY_PAYLOAD_LEN - 1) != p[11])
+		return -1;
+
+	t->seq = p[0];
+	t->tick = p[1] | (p[2] << 8);
+
+	t->adc[0] = (p[3] | (p[4] << 8)) & 0x3ff;
+	t->adc[1] = ((p[4] >> 2) | (p[5] << 6)) & 0x3ff;
+	t->adc[2] = ((p[5] >> 4) | (p[6] << 4)) & 0x3ff;
+	t->adc[3] = ((p[6] >> 6) | (p[7] << 2)) & 0x3ff;
+
+	t->speed = p[8];
+	t->out_stering = p[9];
+	t->out_drive = p[10];
+
+	return 0;
+}
+
+uint8_t telemetry_encode(uint8_t *frame, const uint8_t *payload, uint8_t len) {
+	uint8_t code = 1, pos = 0, out = 1;
+
+	// COBS: each block starts with the offset to the next zero
+	for (uint8_t i = 0; i < len; i++) {
+		if (payload[i] == 0) {
+			frame[pos] = code;
+			pos = out++;
+			code = 1;
+		}
+		else {
+			frame[out++] = payload[i];
+			code++;
+		}
+	}
+
+	frame[pos] = code;
+	frame[out++] = TELEMETRY_DELIMITER;
+
+	return out;
+}
+
+int16_t telemetry_decode(uint8_t *payload, const uint8_t *frame, uint8_t len) {
+	uint8_t in = 0, out = 0;
+
+	while (in < len) {
+		uint8_t code = frame[in++];
+
+		if (code == 0 || in + code - 1 > len)
+			return -1;
+
+		for (uint8_t i = 1; i < code; i++) {
+			if (frame[in] == 0) return -1;
+			payload[out++] = frame[in++];
+		}
+
+		if (code < 0xff && in < len)
+			payload[out++] = 0;
+	}
+
+	return out;
+}
@@ -0,0 +1,87 @@
+/**
+ * Binary telemetry frames
+ *
+ * A frame carries one snapshot of all channels in a fixed layout. It is
+ * protected by a CRC-8 and byte stuffed with COBS, so 0x00 only occurs
+ * as frame delimiter and the receiver can resynchronize at any time.
+ *
+ * Payload (little endian):
+ *	0	sequence number
+ *	1-2	tick (Timer 2 overflows)
+ *	3-7	4 ADC channels, 10 bit each, packed LSB first
+ *	8	speed
+ *	9	out_stering (signed)
+ *	10	out_drive
+ *	11	CRC-8 (polynomial 0x07) over bytes 0-10
+ *
+ * This file is shared with the frontend and must not depend on avr-libc.
+ *
+ * @copyright	2012 Institute Automation of Complex Power Systems (ACS), RWTH Aachen University
+ * @license	http://www.gnu.org/licenses/gpl.txt GNU Public License
+ * @author	Steffen Vogel <info@steffenvogel.de>
+ */
+
+#ifndef _TELEMETRY_FRAME_H_
+#define _TELEMETRY_FRAME_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_PAYLOAD_LEN	12
+#define TELEMETRY_FRAME_LEN	(TELEMETRY_PAYLOAD_LEN + 2)	/* COBS overhead and delimiter */
+#define TELEMETRY_DELIMITER	0x00
+
+#define TELEMETRY_ADC_CHANNELS	4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Snapshot of the telemetry channels
+ */
+struct telemetry {
+	uint8_t seq;
+	uint16_t tick;
+	uint16_t adc[TELEMETRY_ADC_CHANNELS];	/* stering left/right, batt logic/drive */
+	uint8_t speed;
+	int8_t out_stering;
+	uint8_t out_drive;
+};
+
+/**
+ * Pack a snapshot into a payload including CRC
+ *
+ * @param payload	TELEMETRY_PAYLOAD_LEN bytes
+ */
+void telemetry_pack(uint8_t *payload, const struct telemetry *t);
+
+/**
+ * Check CRC and unpack a payload
+ *
+ * @return 0 on success, -1 on CRC error
+ */
+int8_t telemetry_unpack(struct telemetry *t, const uint8_t *payload);
+
+/**
+ * Byte stuff a payload (COBS) and append the delimiter
+ *
+ * @param frame		At least len + 2 bytes
+ * @return		Length of the frame
+ */
+uint8_t telemetry_encode(uint8_t *frame, const uint8_t *payload, uint8_t len);
+
+/**
+ * Remove byte stuffing from a frame without delimiter
+ *
+ * @param payload	At least len - 1 bytes
+ * @return		Length of the payload or -1 if malformed
+ */
+int16_t telemetry_decode(uint8_t *payload, const uint8_t *frame, uint8_t len);
+
+uint8_t telemetry_crc8(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TELEMETRY_FRAME_H_ */
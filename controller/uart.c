@@ -451,6 +451,38 @@ void uart_puts(const char *s )
 }/* uart_puts */
 
 
+/*************************************************************************
+Function: uart_write()
+Purpose:  write block of bytes to ringbuffer without blocking
+Input:    bytes to be transmitted and their number
+Returns:  1 if queued, 0 if the ringbuffer has not enough space
+**************************************************************************/
+unsigned char uart_write(const unsigned char *data, unsigned char len)
+{
+    unsigned char tmphead;
+    unsigned char free;
+
+
+    free = (UART_TxTail - UART_TxHead - 1) & UART_TX_BUFFER_MASK;
+    if ( len > free ) {
+        return 0;   /* drop instead of waiting */
+    }
+
+    tmphead = UART_TxHead;
+    while ( len-- ) {
+        tmphead = (tmphead + 1) & UART_TX_BUFFER_MASK;
+        UART_TxBuf[tmphead] = *data++;
+    }
+    UART_TxHead = tmphead;
+
+    /* enable UDRE interrupt */
+    UART0_CONTROL    |= _BV(UART0_UDRIE);
+
+    return 1;
+
+}/* uart_write */
+
+
 /*************************************************************************
 Function: uart_puts_p()
 Purpose:  transmit string from program memory to UART
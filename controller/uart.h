@@ -154,6 +154,19 @@ extern void uart_putc(unsigned char data);
 extern void uart_puts(const char *s );
 
 
+/**
+ *  @brief   Put a block of bytes to ringbuffer for transmitting via UART without blocking
+ *
+ *  The block is only queued if it fits completely into the circular buffer,
+ *  so this function may be called from interrupt handlers.
+ *
+ *  @param   data bytes to be transmitted
+ *  @param   len  number of bytes
+ *  @return  1 if the block was queued, 0 if there was not enough space
+ */
+extern unsigned char uart_write(const unsigned char *data, unsigned char len);
+
+
 /**
  * @brief    Put string from program memory to ringbuffer for transmitting via UART.
  *
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "Acquisition.h"
+#include "Recorder.h"
+#include "Archive.h"
+#include "Clock.h"
+#include "Profiler.h"
+
+Acquisition::Acquisition(size_t queueSize)
+  : running(false), queue(queueSize), recorder(NULL), archive(NULL)
+{
+	efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (efd < 0) {
+		perror("eventfd");
+		exit(EXIT_FAILURE);
+	}
+}
+
+Acquisition::~Acquisition() {
+	stop();
+	close(efd);
+}
+
+void Acquisition::start() {
+	if (running) return;
+
+	running = true;
+	if (pthread_create(&thread, NULL, main, this)) {
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void Acquisition::stop() {
+	if (!running) return;
+
+	running = false;
+	pthread_join(thread, NULL);
+}
+
+void * Acquisition::main(void *arg) {
+	Acquisition *acq = (Acquisition *) arg;
+
+	acq->run();
+
+	return NULL;
+}
+
+void Acquisition::setChannel(unsigned channel, PlotSeries *series) {
+	if (channel >= channels.size()) channels.resize(channel + 1, NULL);
+
+	channels[channel] = series;
+}
+
+void Acquisition::push(unsigned channel, double value, double time) {
+	Sample s = { time, channel, value };
+
+	if (recorder) recorder->append(s);
+	if (archive) archive->append(s);
+
+	queue.push(s); /* counted as drop if full */
+}
+
+void Acquisition::push(unsigned channel, double value) {
+	push(channel, value, Clock::now());
+}
+
+void Acquisition::flush() {
+	uint64_t one = 1;
+
+	if (write(efd, &one, sizeof(one)) < 0) { } /* counter saturated: consumer is already signaled */
+}
+
+bool Acquisition::reserve() {
+	while (queue.full()) {
+		if (!running) return false;
+
+		flush();
+		usleep(1000);
+	}
+
+	return true;
+}
+
+void Acquisition::handleEvent(int fd) {
+	StageTimer timer(Profiler::STAGE_INGEST);
+
+	uint64_t cnt;
+	if (read(fd, &cnt, sizeof(cnt)) < 0) { } /* just reset the counter */
+
+	Sample batch[BATCH];
+	size_t n;
+
+	while ((n = queue.pop(batch, BATCH)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			if (batch[i].channel < channels.size() && channels[batch[i].channel])
+				channels[batch[i].channel]->push_back(batch[i].value);
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef _ACQUISITION_H_
+#define _ACQUISITION_H_
+
+#include <pthread.h>
+
+#include <vector>
+
+#include "Plot.h"
+#include "EventLoop.h"
+#include "SpscQueue.h"
+
+class Recorder;
+class ArchiveWriter;
+
+/**
+ * Timestamped sample of one telemetry channel
+ */
+struct Sample {
+	double time;
+	unsigned channel;
+	double value;
+};
+
+/**
+ * Base class for data sources running in their own thread
+ *
+ * The acquisition thread runs run() and hands samples to push(). They are
+ * passed through a wait-free queue to the render thread which drains it
+ * into the PlotSeries registered by setChannel() when the eventfd returned
+ * by getFd() becomes readable in the EventLoop.
+ */
+class Acquisition : public EventHandler {
+
+  public:
+	Acquisition(size_t queueSize = 1 << 14);
+	virtual ~Acquisition();
+
+	void start();
+	void stop();
+
+	/**
+	 * Route a channel to a series (render thread)
+	 */
+	void setChannel(unsigned channel, PlotSeries *series);
+
+	/**
+	 * Record every pushed sample, including dropped ones (before start())
+	 */
+	void setRecorder(Recorder *rec) { recorder = rec; }
+
+	/**
+	 * Compress every pushed sample into a long-term archive
+	 */
+	void setArchive(ArchiveWriter *arc) { archive = arc; }
+
+	int getFd() const { return efd; }
+
+	/**
+	 * Drain the queue into the series (render thread)
+	 */
+	void handleEvent(int fd);
+
+	/* queue statistics */
+	size_t getHighWater() const { return queue.getHighWater(); }
+	size_t getCapacity() const { return queue.capacity(); }
+	unsigned long long getDrops() const { return queue.getDrops(); }
+
+  protected:
+	/**
+	 * Body of the acquisition thread, must return when running is false
+	 */
+	virtual void run() = 0;
+
+	/**
+	 * Queue a sample (acquisition thread)
+	 */
+	void push(unsigned channel, double value, double time);
+	void push(unsigned channel, double value);
+
+	/**
+	 * Wake up the render thread after a batch of samples (acquisition thread)
+	 */
+	void flush();
+
+	/**
+	 * Wait until the queue has space instead of dropping (acquisition thread)
+	 *
+	 * Only for sources which can be slowed down, like a replay.
+	 *
+	 * @return false if stop() was called
+	 */
+	bool reserve();
+
+	volatile bool running;
+
+  private:
+	SpscQueue<Sample> queue;
+	std::vector<PlotSeries *> channels;
+	Recorder *recorder;
+	ArchiveWriter *archive;
+
+	pthread_t thread;
+	int efd;
+
+	static void * main(void *arg);
+
+	static const size_t BATCH = 256; /* samples drained per pop */
+};
+
+#endif /* _ACQUISITION_H_ */
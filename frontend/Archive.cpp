@@ -0,0 +1,530 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "Archive.h"
+
+const char Archive::MAGIC[8] = { 'C', 'A', 'R', 'A', 'R', 'C', '\0', '\0' };
+const char Archive::TRAILER_MAGIC[8] = { 'C', 'A', 'R', 'I', 'D', 'X', '\0', '\0' };
+
+/**
+ * MSB-first bit stream
+ */
+class BitWriter {
+
+  public:
+	BitWriter(std::vector<uint8_t> &out) : out(out), acc(0), bits(0) { }
+
+	void write(uint64_t value, int n) {
+		if (n > 32) {
+			write(value >> 32, n - 32);
+			value &= 0xffffffff;
+			n = 32;
+		}
+
+		if (n == 0) return;
+
+		acc |= (value & ((1ULL << n) - 1)) << (64 - bits - n);
+		bits += n;
+
+		while (bits >= 8) {
+			out.push_back(acc >> 56);
+			acc <<= 8;
+			bits -= 8;
+		}
+	}
+
+	void finish() {
+		if (bits) out.push_back(acc >> 56);
+
+		acc = 0;
+		bits = 0;
+	}
+
+  protected:
+	std::vector<uint8_t> &out;
+	uint64_t acc;
+	int bits; /* pending in acc, always < 8 between calls */
+};
+
+class BitReader {
+
+  public:
+	BitReader(const uint8_t *data, size_t len) : p(data), end(data + len), acc(0), bits(0) { }
+
+	uint64_t read(int n) {
+		if (n > 32) {
+			uint64_t high = read(n - 32);
+			return (high << 32) | read(32);
+		}
+
+		if (n == 0) return 0;
+
+		while (bits < n) {
+			acc |= (uint64_t) (p < end ? *p++ : 0) << (56 - bits);
+			bits += 8;
+		}
+
+		uint64_t value = acc >> (64 - n);
+		acc <<= n;
+		bits -= n;
+
+		return value;
+	}
+
+	bool bit() { return read(1); }
+
+  protected:
+	const uint8_t *p, *end;
+	uint64_t acc;
+	int bits;
+};
+
+/**
+ * Variable length integer, short codes for small values
+ *
+ * Used for delta-of-delta timestamps and deltas of integral values.
+ */
+static void writeSmall(BitWriter &w, int64_t v) {
+	if (v == 0) {
+		w.write(0x0, 1);
+	}
+	else if (v >= -63 && v <= 64) {
+		w.write(0x2, 2);
+		w.write(v + 63, 7);
+	}
+	else if (v >= -255 && v <= 256) {
+		w.write(0x6, 3);
+		w.write(v + 255, 9);
+	}
+	else if (v >= -2047 && v <= 2048) {
+		w.write(0xe, 4);
+		w.write(v + 2047, 12);
+	}
+	else {
+		w.write(0xf, 4);
+		w.write(v, 64);
+	}
+}
+
+static int64_t readSmall(BitReader &r) {
+	if (!r.bit()) return 0;
+	if (!r.bit()) return (int64_t) r.read(7) - 63;
+	if (!r.bit()) return (int64_t) r.read(9) - 255;
+	if (!r.bit()) return (int64_t) r.read(12) - 2047;
+
+	return (int64_t) r.read(64);
+}
+
+static uint64_t bitsOf(double d) {
+	uint64_t u;
+	memcpy(&u, &d, sizeof(u));
+
+	return u;
+}
+
+static double doubleOf(uint64_t u) {
+	double d;
+	memcpy(&d, &u, sizeof(d));
+
+	return d;
+}
+
+static bool integral(double v) {
+	return v == floor(v) && fabs(v) < 9007199254740992.0 && !(v == 0 && signbit(v));
+}
+
+Archive::Encoding Archive::encode(const std::vector<int64_t> &time, const std::vector<double> &value, std::vector<uint8_t> &out) {
+	BitWriter w(out);
+	size_t n = time.size();
+	Encoding enc = ENCODING_DELTA;
+
+	/* timestamps: delta-of-delta */
+	int64_t prevDelta = 0;
+
+	w.write(time[0], 64);
+	for (size_t i = 1; i < n; i++) {
+		int64_t delta = time[i] - time[i - 1];
+
+		writeSmall(w, delta - prevDelta);
+		prevDelta = delta;
+	}
+
+	for (size_t i = 0; i < n && enc == ENCODING_DELTA; i++) {
+		if (!integral(value[i])) enc = ENCODING_XOR;
+	}
+
+	if (enc == ENCODING_DELTA) {
+		/* ADC counts and the like: delta */
+		w.write((int64_t) value[0], 64);
+
+		for (size_t i = 1; i < n; i++)
+			writeSmall(w, (int64_t) value[i] - (int64_t) value[i - 1]);
+	}
+	else {
+		/* XOR with the previous value, reusing the previous window of meaningful bits */
+		uint64_t prev = bitsOf(value[0]);
+		int lead = -1, trail = 0;
+
+		w.write(prev, 64);
+
+		for (size_t i = 1; i < n; i++) {
+			uint64_t cur = bitsOf(value[i]);
+			uint64_t x = cur ^ prev;
+
+			if (x == 0) {
+				w.write(0x0, 1);
+			}
+			else {
+				int l = __builtin_clzll(x), t = __builtin_ctzll(x);
+				if (l > 31) l = 31;
+
+				if (lead >= 0 && l >= lead && t >= trail) {
+					w.write(0x2, 2);
+					w.write(x >> trail, 64 - lead - trail);
+				}
+				else {
+					lead = l;
+					trail = t;
+
+					w.write(0x3, 2);
+					w.write(lead, 5);
+					w.write(64 - lead - trail - 1, 6);
+					w.write(x >> trail, 64 - lead - trail);
+				}
+			}
+
+			prev = cur;
+		}
+	}
+
+	w.finish();
+
+	return enc;
+}
+
+void Archive::decode(const uint8_t *data, size_t len, const ArchiveChunk &chunk, std::vector<Sample> &out) {
+	BitReader r(data, len);
+	size_t n = chunk.count, base = out.size();
+
+	if (n == 0) return;
+
+	out.resize(base + n);
+
+	int64_t t = r.read(64), delta = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (i > 0) {
+			delta += readSmall(r);
+			t += delta;
+		}
+
+		out[base + i].time = t * 1e-6;
+		out[base + i].channel = chunk.channel;
+	}
+
+	if (chunk.encoding == ENCODING_DELTA) {
+		int64_t v = r.read(64);
+
+		for (size_t i = 0; i < n; i++) {
+			if (i > 0) v += readSmall(r);
+			out[base + i].value = v;
+		}
+	}
+	else {
+		uint64_t v = r.read(64);
+		int lead = 0, trail = 0;
+
+		out[base].value = doubleOf(v);
+
+		for (size_t i = 1; i < n; i++) {
+			if (r.bit()) {
+				if (r.bit()) {
+					lead = r.read(5);
+					trail = 64 - lead - (r.read(6) + 1);
+				}
+
+				v ^= r.read(64 - lead - trail) << trail;
+			}
+
+			out[base + i].value = doubleOf(v);
+		}
+	}
+}
+
+ArchiveWriter::ArchiveWriter(const char *path, const char * const *names, unsigned channels, size_t chunkSize, double chunkTime)
+  : offset(0), samples(0), chunkSize(chunkSize), chunkTime(chunkTime * 1e6), columns(channels)
+{
+	ArchiveHeader header;
+
+	if (channels > sizeof(header.names) / sizeof(header.names[0])) {
+		fprintf(stderr, "Too many channels for the archive: %u\n", channels);
+		exit(EXIT_FAILURE);
+	}
+
+	for (unsigned i = 0; i < channels; i++) {
+		if (strlen(names[i]) >= sizeof(header.names[i])) {
+			fprintf(stderr, "Channel name too long for the archive: %s\n", names[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, Archive::MAGIC, sizeof(header.magic));
+	header.version = Archive::VERSION;
+	header.channels = channels;
+
+	for (unsigned i = 0; i < channels; i++)
+		strncpy(header.names[i], names[i], sizeof(header.names[i]) - 1);
+
+	write(&header, sizeof(header));
+
+	for (unsigned i = 0; i < channels; i++) {
+		columns[i].time.reserve(chunkSize);
+		columns[i].value.reserve(chunkSize);
+	}
+}
+
+ArchiveWriter::~ArchiveWriter() {
+	ArchiveTrailer trailer;
+
+	flush();
+
+	trailer.index = offset;
+	trailer.entries = index.size();
+	memcpy(trailer.magic, Archive::TRAILER_MAGIC, sizeof(trailer.magic));
+
+	if (!index.empty())
+		write(&index[0], index.size() * sizeof(ArchiveIndexEntry));
+	write(&trailer, sizeof(trailer));
+
+	close(fd);
+}
+
+void ArchiveWriter::append(const Sample &s) {
+	if (s.channel >= columns.size()) return;
+
+	Column &c = columns[s.channel];
+	int64_t t = llrint(s.time * 1e6);
+
+	if (!c.time.empty() && (c.time.size() >= chunkSize || t - c.time[0] > chunkTime))
+		writeChunk(s.channel);
+
+	c.time.push_back(t);
+	c.value.push_back(s.value);
+	samples++;
+}
+
+void ArchiveWriter::flush() {
+	for (unsigned i = 0; i < columns.size(); i++) {
+		if (!columns[i].time.empty())
+			writeChunk(i);
+	}
+}
+
+void ArchiveWriter::writeChunk(unsigned channel) {
+	Column &c = columns[channel];
+	ArchiveChunk chunk;
+	ArchiveIndexEntry entry;
+
+	buffer.clear();
+	chunk.encoding = Archive::encode(c.time, c.value, buffer);
+	chunk.magic = Archive::CHUNK_MAGIC;
+	chunk.channel = channel;
+	chunk.reserved = 0;
+	chunk.count = c.time.size();
+	chunk.bytes = buffer.size();
+	chunk.first = *std::min_element(c.time.begin(), c.time.end()) * 1e-6;
+	chunk.last = *std::max_element(c.time.begin(), c.time.end()) * 1e-6;
+
+	entry.offset = offset;
+	entry.first = chunk.first;
+	entry.last = chunk.last;
+	entry.channel = channel;
+	entry.count = chunk.count;
+	index.push_back(entry);
+
+	write(&chunk, sizeof(chunk));
+	write(&buffer[0], buffer.size());
+
+	c.time.clear();
+	c.value.clear();
+}
+
+void ArchiveWriter::write(const void *data, size_t len) {
+	const char *p = (const char *) data;
+
+	while (len > 0) {
+		ssize_t ret = ::write(fd, p, len);
+		if (ret < 0) {
+			perror("write");
+			exit(EXIT_FAILURE);
+		}
+
+		p += ret;
+		len -= ret;
+		offset += ret;
+	}
+}
+
+static bool byLast(const ArchiveIndexEntry &e, double time) {
+	return e.last < time;
+}
+
+static bool byFirst(const ArchiveIndexEntry &a, const ArchiveIndexEntry &b) {
+	return a.first < b.first;
+}
+
+ArchiveReader::ArchiveReader(const char *path)
+  : chunksRead(0)
+{
+	struct stat st;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+	    memcmp(header.magic, Archive::MAGIC, sizeof(header.magic)) || header.version != Archive::VERSION ||
+	    header.channels > sizeof(header.names) / sizeof(header.names[0])) {
+		fprintf(stderr, "%s: not an archive or unsupported version\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	chunks.resize(header.channels);
+
+	if (!readIndex(st.st_size))
+		scanIndex(st.st_size); /* not closed properly */
+
+	for (unsigned i = 0; i < header.channels; i++)
+		std::sort(chunks[i].begin(), chunks[i].end(), byFirst);
+}
+
+ArchiveReader::~ArchiveReader() {
+	close(fd);
+}
+
+bool ArchiveReader::readIndex(uint64_t size) {
+	ArchiveTrailer trailer;
+
+	if (size < sizeof(header) + sizeof(trailer) ||
+	    pread(fd, &trailer, sizeof(trailer), size - sizeof(trailer)) != sizeof(trailer) ||
+	    memcmp(trailer.magic, Archive::TRAILER_MAGIC, sizeof(trailer.magic)) ||
+	    trailer.index + trailer.entries * sizeof(ArchiveIndexEntry) + sizeof(trailer) != size)
+		return false;
+
+	std::vector<ArchiveIndexEntry> entries(trailer.entries);
+	size_t len = entries.size() * sizeof(ArchiveIndexEntry);
+
+	if (len && pread(fd, &entries[0], len, trailer.index) != (ssize_t) len)
+		return false;
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].channel < header.channels)
+			chunks[entries[i].channel].push_back(entries[i]);
+	}
+
+	return true;
+}
+
+void ArchiveReader::scanIndex(uint64_t size) {
+	uint64_t offset = sizeof(header);
+	ArchiveChunk chunk;
+
+	while (offset + sizeof(chunk) <= size &&
+	       pread(fd, &chunk, sizeof(chunk), offset) == sizeof(chunk) &&
+	       chunk.magic == Archive::CHUNK_MAGIC && chunk.channel < header.channels &&
+	       offset + sizeof(chunk) + chunk.bytes <= size) {
+		ArchiveIndexEntry entry = { offset, chunk.first, chunk.last, chunk.channel, chunk.count };
+
+		chunks[chunk.channel].push_back(entry);
+		offset += sizeof(chunk) + chunk.bytes;
+	}
+}
+
+int ArchiveReader::lookup(const char *name) const {
+	for (unsigned i = 0; i < header.channels; i++) {
+		if (!strncmp(header.names[i], name, sizeof(header.names[i])))
+			return i;
+	}
+
+	return -1;
+}
+
+size_t ArchiveReader::read(unsigned channel, double from, double to, std::vector<Sample> &out) {
+	size_t before = out.size();
+
+	if (channel >= chunks.size()) return 0;
+
+	const std::vector<ArchiveIndexEntry> &index = chunks[channel];
+	std::vector<ArchiveIndexEntry>::const_iterator it = std::lower_bound(index.begin(), index.end(), from, byLast);
+
+	for (; it != index.end() && it->first <= to; ++it) {
+		ArchiveChunk chunk;
+
+		if (pread(fd, &chunk, sizeof(chunk), it->offset) != sizeof(chunk) || chunk.magic != Archive::CHUNK_MAGIC)
+			continue;
+
+		buffer.resize(chunk.bytes);
+		if (chunk.bytes && pread(fd, &buffer[0], chunk.bytes, it->offset + sizeof(chunk)) != (ssize_t) chunk.bytes)
+			continue;
+
+		chunksRead++;
+
+		scratch.clear();
+		Archive::decode(buffer.empty() ? NULL : &buffer[0], buffer.size(), chunk, scratch);
+
+		for (size_t i = 0; i < scratch.size(); i++) {
+			if (scratch[i].time >= from && scratch[i].time <= to)
+				out.push_back(scratch[i]);
+		}
+	}
+
+	return out.size() - before;
+}
+
+double ArchiveReader::getFirst() const {
+	double first = INFINITY;
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		if (!chunks[i].empty() && chunks[i].front().first < first)
+			first = chunks[i].front().first;
+	}
+
+	return first;
+}
+
+double ArchiveReader::getLast() const {
+	double last = -INFINITY;
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		for (size_t j = 0; j < chunks[i].size(); j++) {
+			if (chunks[i][j].last > last)
+				last = chunks[i][j].last;
+		}
+	}
+
+	return last;
+}
+
+size_t ArchiveReader::getChunks() const {
+	size_t n = 0;
+
+	for (size_t i = 0; i < chunks.size(); i++)
+		n += chunks[i].size();
+
+	return n;
+}
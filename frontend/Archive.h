@@ -0,0 +1,185 @@
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "Acquisition.h"
+
+/**
+ * On-disk layout of an archive
+ *
+ * A header with the schema is followed by compressed chunks of one channel
+ * each. Closing the archive appends an index of all chunks and a trailer.
+ * Without the trailer (crash) the index is rebuilt from the chunk headers.
+ */
+struct ArchiveHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t channels;
+	char names[32][32];	/* NUL-terminated */
+};
+
+struct ArchiveChunk {
+	uint32_t magic;
+	uint16_t channel;
+	uint8_t encoding;	/* of the values, see Archive::Encoding */
+	uint8_t reserved;
+	uint32_t count;		/* samples */
+	uint32_t bytes;		/* payload following this header */
+	double first, last;	/* time range */
+};
+
+struct ArchiveIndexEntry {
+	uint64_t offset;	/* of the ArchiveChunk */
+	double first, last;
+	uint32_t channel;
+	uint32_t count;
+};
+
+struct ArchiveTrailer {
+	uint64_t index;		/* offset of the first ArchiveIndexEntry */
+	uint64_t entries;
+	char magic[8];
+};
+
+/**
+ * Compressed long-term storage of telemetry
+ *
+ * Samples are collected per channel into chunks which are compressed
+ * column-wise like in Facebook's Gorilla: timestamps (in microseconds) by
+ * delta-of-delta, integral values (ADC counts) by delta and other values
+ * by XOR with the previous one.
+ */
+class Archive {
+
+  public:
+	enum Encoding {
+		ENCODING_DELTA,	/* all values are integers */
+		ENCODING_XOR
+	};
+
+	static const char MAGIC[8];
+	static const char TRAILER_MAGIC[8];
+	static const uint32_t CHUNK_MAGIC = 0x4b4e4843; /* "CHNK" */
+	static const uint32_t VERSION = 2;
+
+	/**
+	 * Compress a chunk
+	 *
+	 * @return Encoding of the values
+	 */
+	static Encoding encode(const std::vector<int64_t> &time, const std::vector<double> &value, std::vector<uint8_t> &out);
+
+	/**
+	 * Decompress a chunk and append the samples to out
+	 */
+	static void decode(const uint8_t *data, size_t len, const ArchiveChunk &chunk, std::vector<Sample> &out);
+};
+
+/**
+ * Appends samples to an archive (single thread)
+ */
+class ArchiveWriter {
+
+  public:
+	/**
+	 * @param chunkSize	Samples per chunk and channel
+	 * @param chunkTime	Maximal time span of a chunk in seconds
+	 */
+	ArchiveWriter(const char *path, const char * const *names, unsigned channels,
+		size_t chunkSize = 4096, double chunkTime = 60);
+	~ArchiveWriter();
+
+	void append(const Sample &s);
+
+	/**
+	 * Write all pending chunks
+	 */
+	void flush();
+
+	unsigned long long getBytes() const { return offset; }
+	unsigned long long getSamples() const { return samples; }
+
+  protected:
+	struct Column {
+		std::vector<int64_t> time;
+		std::vector<double> value;
+	};
+
+	int fd;
+	uint64_t offset;
+	unsigned long long samples;
+
+	size_t chunkSize;
+	int64_t chunkTime;
+
+	std::vector<Column> columns;
+	std::vector<ArchiveIndexEntry> index;
+	std::vector<uint8_t> buffer;
+
+	void writeChunk(unsigned channel);
+	void write(const void *data, size_t len);
+
+  private:
+	/* not copyable */
+	ArchiveWriter(const ArchiveWriter &);
+	ArchiveWriter & operator=(const ArchiveWriter &);
+};
+
+/**
+ * Time-range queries on an archive
+ */
+class ArchiveReader {
+
+  public:
+	ArchiveReader(const char *path);
+	~ArchiveReader();
+
+	/**
+	 * Find a channel by its name in the schema
+	 *
+	 * @return channel or -1 if unknown
+	 */
+	int lookup(const char *name) const;
+
+	/**
+	 * Append all samples of a channel within [from, to] to out
+	 *
+	 * Only the chunks overlapping the range are read from the disk.
+	 *
+	 * @return Number of samples appended
+	 */
+	size_t read(unsigned channel, double from, double to, std::vector<Sample> &out);
+
+	/* time range of all chunks */
+	double getFirst() const;
+	double getLast() const;
+
+	/* chunks read from the disk so far */
+	unsigned long long getChunksRead() const { return chunksRead; }
+	size_t getChunks() const;
+
+  protected:
+	int fd;
+	ArchiveHeader header;
+
+	/* chunks of each channel, sorted by time */
+	std::vector<std::vector<ArchiveIndexEntry> > chunks;
+
+	unsigned long long chunksRead;
+	std::vector<uint8_t> buffer;
+	std::vector<Sample> scratch;
+
+	bool readIndex(uint64_t size);
+	void scanIndex(uint64_t size);
+
+  private:
+	/* not copyable */
+	ArchiveReader(const ArchiveReader &);
+	ArchiveReader & operator=(const ArchiveReader &);
+};
+
+#endif /* _ARCHIVE_H_ */
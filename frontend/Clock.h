@@ -0,0 +1,20 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <time.h>
+
+class Clock {
+
+  public:
+	/**
+	 * Monotonic time in seconds
+	 */
+	static double now() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+};
+
+#endif /* _CLOCK_H_ */
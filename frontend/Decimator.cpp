@@ -0,0 +1,108 @@
+#include <math.h>
+
+#include "Decimator.h"
+
+/**
+ * Emit the aggregate of one pixel column in sample order without duplicates
+ */
+static inline void flush(std::vector<Point> &out, const Point &first, const Point &min, const Point &max, const Point &last) {
+	const Point &a = (min.x < max.x) ? min : max;
+	const Point &b = (min.x < max.x) ? max : min;
+
+	out.push_back(first);
+	if (a.x != first.x) out.push_back(a);
+	if (b.x != a.x && b.x != last.x) out.push_back(b);
+	if (last.x != first.x && last.x != a.x) out.push_back(last);
+}
+
+void Decimator::m4(const double *span[2], const size_t len[2], double step, std::vector<Point> &out) {
+	Point first, last, min, max;
+	long column = -1;
+	size_t i = 0;
+
+	out.clear();
+
+	for (int s = 0; s < 2; s++) {
+		for (size_t j = 0; j < len[s]; j++, i++) {
+			Point p = { (double) i, span[s][j] };
+			long c = (long) (i * step);
+
+			if (c == column) {
+				if (p.y < min.y) min = p;
+				if (p.y > max.y) max = p;
+				last = p;
+				continue;
+			}
+
+			if (column >= 0) flush(out, first, min, max, last);
+
+			column = c;
+			first = last = min = max = p;
+		}
+	}
+
+	if (column >= 0) flush(out, first, min, max, last);
+}
+
+void Decimator::lttb(const double *span[2], const size_t len[2], size_t threshold, std::vector<Point> &out) {
+	size_t n = len[0] + len[1];
+
+	out.clear();
+
+	if (threshold < 3 || threshold >= n) { /* nothing to reduce */
+		for (int s = 0; s < 2; s++) {
+			for (size_t j = 0; j < len[s]; j++) {
+				Point p = { (double) out.size(), span[s][j] };
+				out.push_back(p);
+			}
+		}
+		return;
+	}
+
+#define AT(i) (((i) < len[0]) ? span[0][i] : span[1][(i) - len[0]])
+
+	double every = (double) (n - 2) / (threshold - 2);
+	size_t a = 0;
+
+	Point p = { 0, AT(0) };
+	out.push_back(p);
+
+	for (size_t b = 0; b < threshold - 2; b++) {
+		/* average of the next bucket */
+		size_t start = (size_t) floor((b + 1) * every) + 1;
+		size_t end = (size_t) floor((b + 2) * every) + 1;
+		if (end > n) end = n;
+
+		double avgX = 0, avgY = 0;
+		for (size_t i = start; i < end; i++) {
+			avgX += i;
+			avgY += AT(i);
+		}
+		avgX /= end - start;
+		avgY /= end - start;
+
+		/* point of the current bucket with the largest triangle */
+		start = (size_t) floor(b * every) + 1;
+		end = (size_t) floor((b + 1) * every) + 1;
+
+		double ax = a, ay = AT(a), area = -1;
+		size_t next = start;
+
+		for (size_t i = start; i < end; i++) {
+			double t = fabs((ax - avgX) * (AT(i) - ay) - (ax - i) * (avgY - ay));
+			if (t > area) {
+				area = t;
+				next = i;
+			}
+		}
+
+		Point q = { (double) next, AT(next) };
+		out.push_back(q);
+		a = next;
+	}
+
+	Point l = { (double) (n - 1), AT(n - 1) };
+	out.push_back(l);
+
+#undef AT
+}
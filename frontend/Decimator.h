@@ -0,0 +1,45 @@
+#ifndef _DECIMATOR_H_
+#define _DECIMATOR_H_
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * Point in sample space: x is the sample index, y the value
+ */
+struct Point {
+	double x, y;
+};
+
+/**
+ * Reduce a series to the points which are visible at a given resolution
+ *
+ * The input are the two contiguous spans of a RingBuffer (see
+ * RingBuffer::spans()). The output vector is reused to avoid allocations.
+ */
+class Decimator {
+
+  public:
+	/**
+	 * M4 aggregation
+	 *
+	 * Keeps the first, minimal, maximal and last sample of each pixel
+	 * column, so the rasterized line is identical to the full resolution
+	 * one (no spikes get lost).
+	 *
+	 * @param step	Width of one sample in pixels
+	 */
+	static void m4(const double *span[2], const size_t len[2], double step, std::vector<Point> &out);
+
+	/**
+	 * Largest-Triangle-Three-Buckets downsampling
+	 *
+	 * Selects one sample per bucket which spans the largest triangle with
+	 * its neighbours. Gives smoother lines than m4() but is not exact.
+	 *
+	 * @param threshold	Number of output points (typically the plot width)
+	 */
+	static void lttb(const double *span[2], const size_t len[2], size_t threshold, std::vector<Point> &out);
+};
+
+#endif /* _DECIMATOR_H_ */
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+
+#include <vector>
+
+#include "EventLoop.h"
+#include "Clock.h"
+#include "Profiler.h"
+
+EventLoop::EventLoop(double fps)
+  : interval(1.0 / fps), lastFrame(0), pending(false), running(false), governor(NULL)
+{
+	timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer < 0) {
+		perror("timerfd_create");
+		exit(EXIT_FAILURE);
+	}
+}
+
+EventLoop::~EventLoop() {
+	close(timer);
+}
+
+void EventLoop::addPlot(Plot *plot) {
+	plots.push_back(plot);
+	requestFrame(); /* initial frame */
+}
+
+void EventLoop::addSource(int fd, EventHandler *handler) {
+	sources[fd] = handler;
+}
+
+void EventLoop::removeSource(int fd) {
+	sources.erase(fd);
+}
+
+void EventLoop::requestFrame() {
+	if (pending) return;
+
+	double delay = lastFrame + interval - Clock::now();
+	if (delay < 1e-6) delay = 1e-6; /* a zero value would disarm the timer */
+
+	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+	its.it_value.tv_sec = (time_t) delay;
+	its.it_value.tv_nsec = (long) ((delay - its.it_value.tv_sec) * 1e9);
+
+	timerfd_settime(timer, 0, &its, NULL);
+	pending = true;
+}
+
+void EventLoop::run() {
+	Display *display = XWindow::isConnected() ? XWindow::getDisplay() : NULL; /* headless */
+	std::vector<struct pollfd> fds;
+
+	running = true;
+	while (running) {
+		/* Xlib may already have read events from the socket */
+		if (display) {
+			handleX();
+			XFlush(display);
+		}
+
+		fds.clear();
+
+		/* poll() ignores negative descriptors */
+		struct pollfd pfd = { display ? ConnectionNumber(display) : -1, POLLIN, 0 };
+		fds.push_back(pfd);
+
+		pfd.fd = timer;
+		fds.push_back(pfd);
+
+		for (std::map<int, EventHandler *>::iterator it = sources.begin(); it != sources.end(); it++) {
+			pfd.fd = it->first;
+			fds.push_back(pfd);
+		}
+
+		if (poll(&fds[0], fds.size(), -1) < 0) {
+			if (errno == EINTR) continue;
+
+			perror("poll");
+			break;
+		}
+
+		for (size_t i = 2; i < fds.size(); i++) {
+			if (fds[i].revents) {
+				std::map<int, EventHandler *>::iterator it = sources.find(fds[i].fd);
+				if (it != sources.end()) {
+					it->second->handleEvent(fds[i].fd);
+					requestFrame();
+				}
+			}
+		}
+
+		if (fds[1].revents & POLLIN) {
+			uint64_t expirations;
+			if (read(timer, &expirations, sizeof(expirations)) > 0) {
+				pending = false;
+				frame();
+			}
+		}
+	}
+}
+
+void EventLoop::handleX() {
+	Display *display = XWindow::getDisplay();
+
+	while (XPending(display)) {
+		XEvent e;
+		XNextEvent(display, &e);
+
+		for (std::list<Plot *>::iterator it = plots.begin(); it != plots.end(); it++) {
+			RefPtr<XWindow> window = (*it)->getWindow();
+
+			if (window && window->getWindow() == e.xany.window) {
+				(*it)->handleEvent(&e);
+				requestFrame();
+				break;
+			}
+		}
+	}
+}
+
+void EventLoop::frame() {
+	double start = Clock::now();
+	bool skipped = false, drawn = false;
+
+	if (governor) governor->tick();
+
+	for (std::list<Plot *>::iterator it = plots.begin(); it != plots.end(); it++) {
+		Plot *plot = *it;
+
+		if (governor) {
+			if (!governor->isDue(plot)) {
+				skipped = skipped || plot->isDirty();
+				continue;
+			}
+
+			governor->apply(plot);
+		}
+
+		if (plot->update())
+			drawn = true;
+	}
+
+	lastFrame = Clock::now();
+
+	if (drawn) {
+		if (governor) governor->frame(lastFrame - start);
+		Profiler::frame();
+	}
+
+	/* catch up with the plots left out, even if no more data arrives */
+	if (skipped)
+		requestFrame();
+}
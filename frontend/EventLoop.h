@@ -0,0 +1,73 @@
+#ifndef _EVENTLOOP_H_
+#define _EVENTLOOP_H_
+
+#include <list>
+#include <map>
+
+#include "Plot.h"
+#include "Governor.h"
+
+/**
+ * Interface for readable file descriptors watched by the EventLoop
+ */
+class EventHandler {
+
+  public:
+	virtual ~EventHandler() { }
+
+	virtual void handleEvent(int fd) = 0;
+};
+
+/**
+ * Main loop of the frontend
+ *
+ * Waits on the X connection, the registered data sources and a frame
+ * timer at the same time. Frames are only rendered after something
+ * happened and at most with the given rate, so the loop sleeps while
+ * no telemetry arrives.
+ */
+class EventLoop {
+
+  public:
+	EventLoop(double fps = 50);
+	virtual ~EventLoop();
+
+	void addPlot(Plot *plot);
+
+	/**
+	 * Adapt the quality of the plots to the frame time (not owned, may be NULL)
+	 */
+	void setGovernor(Governor *governor) { this->governor = governor; }
+	Governor * getGovernor() const { return governor; }
+
+	/**
+	 * Watch a file descriptor
+	 *
+	 * A frame is requested after each call of the handler.
+	 */
+	void addSource(int fd, EventHandler *handler);
+	void removeSource(int fd);
+
+	/**
+	 * Schedule a frame not later than one frame interval from now
+	 */
+	void requestFrame();
+
+	void run();
+	void stop() { running = false; }
+
+  protected:
+	int timer; /* timerfd for frame pacing */
+	double interval, lastFrame;
+	bool pending;
+	volatile bool running;
+
+	std::list<Plot *> plots;
+	std::map<int, EventHandler *> sources;
+	Governor *governor;
+
+	void handleX();
+	void frame();
+};
+
+#endif /* _EVENTLOOP_H_ */
@@ -0,0 +1,78 @@
+#include "Governor.h"
+
+Governor::Governor(double budget)
+  : budget(budget), average(0), level(LEVEL_FULL), frames(0), changes(0), ticks(0),
+    over(0), under(0), hold(RESTORE_FRAMES), restored(0), degraded(0)
+{ }
+
+bool Governor::frame(double time) {
+	const double ALPHA = 0.1; /* weight of the newest frame */
+	const double HEADROOM = 0.5; /* restore below this part of the budget */
+
+	frames++;
+	average = (average > 0) ? average + ALPHA * (time - average) : time;
+
+	if (average > budget) {
+		over++;
+		under = 0;
+	}
+	else if (average < HEADROOM * budget) {
+		under++;
+		over = 0;
+	}
+	else {
+		over = under = 0;
+	}
+
+	/* the last restore held */
+	if (restored > degraded && frames - restored >= RESTORE_FRAMES)
+		hold = RESTORE_FRAMES;
+
+	if (over >= DEGRADE_FRAMES && level + 1 < LEVELS) {
+		/* first degrade soon after a restore: wait longer next time */
+		if (restored > degraded && frames - restored < 2 * hold && hold < MAX_HOLD)
+			hold *= 2;
+
+		level = (enum Level) (level + 1);
+		degraded = frames;
+	}
+	else if (under >= hold && level > LEVEL_FULL) {
+		level = (enum Level) (level - 1);
+		restored = frames;
+	}
+	else {
+		return false;
+	}
+
+	/* measure the new level from scratch */
+	average = 0;
+	over = under = 0;
+	changes++;
+
+	return true;
+}
+
+void Governor::apply(Plot *plot) const {
+	bool aliased = level >= LEVEL_ALIASED;
+	double coarse = (level >= LEVEL_COARSEST) ? 4 : (level >= LEVEL_COARSE) ? 2 : 1;
+
+	plot->degrade(aliased, coarse);
+}
+
+bool Governor::isDue(const Plot *plot) const {
+	if (level < LEVEL_UNFOCUSED || plot->isFocused())
+		return true;
+
+	return ticks % UNFOCUSED_DIVISOR == 0;
+}
+
+const char * Governor::getName(enum Level level) {
+	switch (level) {
+		case LEVEL_FULL:      return "full";
+		case LEVEL_UNFOCUSED: return "unfocused";
+		case LEVEL_ALIASED:   return "aliased";
+		case LEVEL_COARSE:    return "coarse";
+		case LEVEL_COARSEST:  return "coarsest";
+		default:              return "unknown";
+	}
+}
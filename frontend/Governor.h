@@ -0,0 +1,81 @@
+#ifndef _GOVERNOR_H_
+#define _GOVERNOR_H_
+
+#include "Plot.h"
+
+/**
+ * Trades rendering quality for frame time
+ *
+ * The EventLoop reports the time spent on each frame (rendering and
+ * presenting all plots). While its moving average stays above the budget
+ * the quality drops by one level, the cheapest visual loss first. It is
+ * restored one level at a time after the average stayed well below the
+ * budget for a while. Levels that were restored too early are held longer
+ * next time, so the quality does not oscillate.
+ */
+class Governor {
+
+  public:
+	enum Level {
+		LEVEL_FULL,		/* as configured */
+		LEVEL_UNFOCUSED,	/* plots without input focus at a reduced rate */
+		LEVEL_ALIASED,		/* no antialiasing of the series */
+		LEVEL_COARSE,		/* decimation to 2 pixels per bucket */
+		LEVEL_COARSEST,		/* decimation to 4 pixels per bucket */
+		LEVELS
+	};
+
+	/**
+	 * @param budget	Time per frame in seconds
+	 */
+	Governor(double budget);
+
+	/**
+	 * Account the time of a frame
+	 *
+	 * @return true if the level changed
+	 */
+	bool frame(double time);
+
+	/**
+	 * Count a tick of the EventLoop, whether or not anything gets drawn
+	 */
+	void tick() { ticks++; }
+
+	/**
+	 * Configure a plot for the current level
+	 */
+	void apply(Plot *plot) const;
+
+	/**
+	 * Whether a plot gets updated in this tick
+	 */
+	bool isDue(const Plot *plot) const;
+
+	void setBudget(double budget) { this->budget = budget; }
+	double getBudget() const { return budget; }
+
+	enum Level getLevel() const { return level; }
+	static const char * getName(enum Level level);
+
+	/* moving average of the frame time in seconds */
+	double getAverage() const { return average; }
+	unsigned long getChanges() const { return changes; }
+
+  protected:
+	double budget, average;
+	enum Level level;
+
+	unsigned long frames, changes;
+	unsigned long ticks; /* paces the plots without focus, also while nothing is drawn */
+	unsigned long over, under; /* consecutive frames above and well below the budget */
+	unsigned long hold; /* frames well below the budget before restoring */
+	unsigned long restored, degraded; /* frame of the last change either way */
+
+	static const int UNFOCUSED_DIVISOR = 4; /* update every 4th tick */
+	static const unsigned long DEGRADE_FRAMES = 10;
+	static const unsigned long RESTORE_FRAMES = 100;
+	static const unsigned long MAX_HOLD = 800;
+};
+
+#endif /* _GOVERNOR_H_ */
@@ -1,61 +1,958 @@
+#include <stdio.h>
 #include <math.h>
-#include <float.h>
 
 #include <iostream>
 
 #include "Plot.h"
+#include "Clock.h"
+#include "Profiler.h"
 
-PlotSeries::PlotSeries(PlotSeries::Style style, Color color)
-  : color(color), style(style)
+PlotSeries::PlotSeries(PlotSeries::Style style, Color color, size_t capacity)
+  : RingBuffer<double>(capacity), color(color), style(style), decimation(DECIMATION_M4), raster(RASTER_NONE),
+    lineWidth(2), markerRadius(2), extrema(capacity),
+    pushed(0), removed(0)
 { }
 
-void PlotSeries::draw(RefPtr<Context> ctx) {
+void PlotSeries::push_back(double value) {
+	if (full()) extrema.evict();
+
+	RingBuffer<double>::push_back(value);
+	extrema.push(value);
+	history.push(value);
+	pushed++;
+}
+
+void PlotSeries::pop_front() {
+	if (empty()) return;
+
+	RingBuffer<double>::pop_front();
+	extrema.evict();
+	removed++;
+}
+
+void PlotSeries::clear() {
+	RingBuffer<double>::clear();
+	extrema.clear();
+	history.clear();
+	removed++;
+}
+
+void PlotSeries::getScale(const Rect &area, double *scale, double *offset) const {
+	getScale(area, extrema.min(), extrema.max(), scale, offset);
+}
+
+void PlotSeries::getScale(const Rect &area, double min, double max, double *scale, double *offset) {
+	if (max > min) {
+		*scale = area.height / (max - min);
+		*offset = area.y + area.height + min * *scale;
+	}
+	else { /* flat line in the middle */
+		*scale = 0;
+		*offset = area.y + area.height / 2;
+	}
+}
+
+Rect PlotSeries::getBounds(const Rect &area) const {
+	Rect r = { area.x, area.y, 0, 0 };
+	if (empty()) return r;
+
+	double scale, offset;
+	getScale(area, &scale, &offset);
+
+	double step = (capacity() > 1) ? area.width / (capacity() - 1) : 0;
+
+	/* a miter reaches up to 5 line widths (cairo's miter limit is 10) */
+	double pad = ((style == STYLE_SCATTER) ? markerRadius : 5 * lineWidth) + 1;
+	double top = offset - max() * scale, bottom = offset - min() * scale;
+
+	r.x = area.x - pad;
+	r.y = top - pad;
+	r.width = (size() - 1) * step + 2 * pad;
+	r.height = bottom - top + 2 * pad;
+
+	return r;
+}
+
+/**
+ * Path builder of trace() for cairo
+ */
+struct CairoPath {
+	RefPtr<Context> ctx;
+
+	void moveTo(double x, double y) { ctx->move_to(x, y); }
+	void lineTo(double x, double y) { ctx->line_to(x, y); }
+};
+
+/**
+ * Path builder of trace() for STYLE_SPLINE
+ *
+ * Monotone cubic interpolation (Steffen) rather than Catmull-Rom: the curve
+ * does not overshoot the samples, so it stays within the autoscale. Each
+ * segment is emitted as a Bezier curve as soon as the point after it is
+ * known, the path is never stored.
+ */
+class SplinePath {
+
+  public:
+	SplinePath(RefPtr<Context> ctx) : ctx(ctx), count(0), slope(0) { }
+
+	void moveTo(double x, double y) {
+		finish();
+		ctx->move_to(x, y);
+		cur.x = x;
+		cur.y = y;
+		count = 1;
+	}
+
+	void lineTo(double x, double y) {
+		Point next = { x, y };
+
+		if (count == 1)
+			slope = secant(cur, next);
+		else
+			segment(tangent(next));
+
+		prev = cur;
+		cur = next;
+		count = 2;
+	}
+
+	/* the last segment */
+	void finish() {
+		if (count == 2)
+			segment(secant(prev, cur));
+
+		count = 0;
+	}
+
+  protected:
+	RefPtr<Context> ctx;
+	Point prev, cur;
+	int count;
+	double slope; /* dy/dx at prev */
+
+	static double secant(const Point &a, const Point &b) {
+		return (b.x > a.x) ? (b.y - a.y) / (b.x - a.x) : 0;
+	}
+
+	/* at cur, limited so the curve is monotone between the points */
+	double tangent(const Point &next) const {
+		double h0 = cur.x - prev.x, h1 = next.x - cur.x;
+
+		if (h0 <= 0 || h1 <= 0) /* several points in a pixel column */
+			return 0;
+
+		double s0 = (cur.y - prev.y) / h0, s1 = (next.y - cur.y) / h1;
+		if (s0 * s1 <= 0) return 0; /* extremum */
+
+		double p = (s0 * h1 + s1 * h0) / (h0 + h1);
+		double m = fabs(s0) < fabs(s1) ? fabs(s0) : fabs(s1);
+		if (0.5 * fabs(p) < m) m = 0.5 * fabs(p);
+
+		return (s0 > 0) ? 2 * m : -2 * m;
+	}
+
+	/* from prev to cur */
+	void segment(double end) {
+		double h = (cur.x - prev.x) / 3;
+
+		if (h > 0)
+			ctx->curve_to(prev.x + h, prev.y + slope * h, cur.x - h, cur.y - end * h, cur.x, cur.y);
+		else
+			ctx->line_to(cur.x, cur.y);
+
+		slope = end;
+	}
+};
+
+/**
+ * Path builder of trace() for STYLE_SCATTER without direct access to the pixels
+ */
+struct MarkerPath {
+	RefPtr<Context> ctx;
+	double radius;
+
+	void moveTo(double x, double y) {
+		ctx->move_to(x + radius, y);
+		ctx->arc(x, y, radius, 0, 2 * M_PI);
+	}
+
+	void lineTo(double x, double y) { moveTo(x, y); }
+};
+
+/**
+ * Path builder of trace() which stamps a marker at each point
+ */
+struct StampPath {
+	Rasterizer *rasterizer;
+
+	void moveTo(double x, double y) { rasterizer->stamp(x, y); }
+	void lineTo(double x, double y) { rasterizer->stamp(x, y); }
+};
+
+void PlotSeries::draw(RefPtr<Context> ctx, const Rect &area, double coarse) {
+	if (empty()) return;
+
+	StageTimer timer(Profiler::STAGE_AUTOSCALE);
+
+	/* autoscale to the extrema of the current window */
+	double scale, offset;
+	getScale(area, &scale, &offset);
+
+	double step = (capacity() > 1) ? area.width / (capacity() - 1) : 0;
+
+	/* thin solid lines and markers directly into the pixels */
+	RefPtr<ImageSurface> image;
+	if (style == STYLE_SCATTER || (raster != RASTER_NONE && style == STYLE_LINE && lineWidth <= 1 && dashes.empty()))
+		image = RefPtr<ImageSurface>::cast_dynamic(ctx->get_target());
+
+	if (image) {
+		timer.next(Profiler::STAGE_STROKE); /* path and pixels at once */
+		image->flush();
+
+		bool aa = ctx->get_antialias() != ANTIALIAS_NONE && (style == STYLE_SCATTER || raster == RASTER_ANTIALIASED);
+		Rasterizer r(image->get_data(), image->get_width(), image->get_height(), image->get_stride(), aa);
+		r.setColor(color.red, color.green, color.blue);
+
+		/* the pixels are not clipped by cairo */
+		double cx0, cy0, cx1, cy1;
+		ctx->get_clip_extents(cx0, cy0, cx1, cy1);
+
+		if (style == STYLE_SCATTER) {
+			StampPath path = { &r };
+
+			/* markers at the border are not cut */
+			double x0 = fmax(area.x - markerRadius, cx0), y0 = fmax(area.y - markerRadius, cy0);
+			double x1 = fmin(area.x + area.width + markerRadius, cx1), y1 = fmin(area.y + area.height + markerRadius, cy1);
+
+			r.setClip(x0, y0, x1 - x0, y1 - y0);
+			r.setMarker(markerRadius, stamped);
+
+			/* every sample is a marker, the pixel positions are deduplicated instead */
+			trace(path, area, step, offset, scale, false);
+		}
+		else {
+			double x0 = fmax(area.x, cx0), y0 = fmax(area.y, cy0);
+			double x1 = fmin(area.x + area.width, cx1), y1 = fmin(area.y + area.height, cy1);
+
+			r.setClip(x0, y0, x1 - x0, y1 - y0);
+			trace(r, area, step, offset, scale, true, coarse);
+		}
+
+		image->mark_dirty();
+		return;
+	}
+
+	timer.next(Profiler::STAGE_PATH);
 	ctx->set_source_rgb(color.red, color.green, color.blue); /* set series color */
 
-	/* determine maxima and minima for autoscale */
-	double min = DBL_MAX, max = DBL_MIN;
-	for (std::list<double>::iterator it = begin(); it != end(); it++) {
-		if (*it > max) max = *it;
-		if (*it < min) min = *it;
+	if (style == STYLE_SCATTER) {
+		MarkerPath path = { ctx, markerRadius };
+
+		trace(path, area, step, offset, scale, false);
+
+		timer.next(Profiler::STAGE_STROKE);
+		ctx->fill();
+		return;
+	}
+
+	ctx->set_line_width(lineWidth);
+	ctx->set_dash(dashes, 0);
+
+	if (style == STYLE_SPLINE) {
+		SplinePath path(ctx);
+
+		trace(path, area, step, offset, scale, true, coarse);
+		path.finish();
 	}
+	else {
+		CairoPath path = { ctx };
 
-	/* stroke */
+		trace(path, area, step, offset, scale, true, coarse);
+	}
 
-	int width = 800;//dynamic_cast<RefPtr<XlibSurface>>(ctx->get_target())->get_width();
-	int height = 400;//dynamic_cast<RefPtr<XlibSurface>>(ctx->get_target())->get_height();
+	timer.next(Profiler::STAGE_STROKE);
+	ctx->stroke();
+}
 
-	ctx->move_to(Plot::PADDING, (height/2) + (height-2*Plot::PADDING) * (front()/max));
+template <class Path>
+void PlotSeries::emit(Path &path, size_t n, bool start) {
+	size_t i = 0;
 
-	int i = 0;
-	for (std::list<double>::iterator it = begin(); it != end(); it++) {
+	if (start) {
+		path.moveTo(coords[0].x, coords[0].y);
 		i++;
-		ctx->line_to(i * 2 + Plot::PADDING, (height/2) + (height-2*Plot::PADDING) * (*it/max*0.5));
 	}
+
+	for (; i < n; i++)
+		path.lineTo(coords[i].x, coords[i].y);
+}
+
+template <class Path>
+void PlotSeries::trace(Path &path, const Rect &area, double step, double offset, double scale, bool decimate, double coarse) {
+	const double *span[2];
+	size_t len[2];
+	spans(&span[0], &len[0], &span[1], &len[1]);
+
+	/* pixel coordinates in blocks which stay in the cache until they are used */
+	if (decimate && decimation != DECIMATION_NONE && step < 0.5 * coarse) { /* more than two samples per bucket */
+		if (decimation == DECIMATION_LTTB)
+			Decimator::lttb(span, len, (size_t) (area.width / coarse), points);
+		else
+			Decimator::m4(span, len, step / coarse, points);
+
+		for (size_t i = 0; i < points.size(); i += BLOCK) {
+			size_t n = (points.size() - i < BLOCK) ? points.size() - i : BLOCK;
+
+			Transform::points(&points[i], n, area.x, step, offset, scale, coords);
+			emit(path, n, i == 0);
+		}
+	}
+	else {
+		for (size_t s = 0, i = 0; s < 2; i += len[s], s++) {
+			for (size_t j = 0; j < len[s]; j += BLOCK) {
+				size_t n = (len[s] - j < BLOCK) ? len[s] - j : BLOCK;
+
+				Transform::samples(span[s] + j, n, i + j, area.x, step, offset, scale, coords);
+				emit(path, n, i + j == 0);
+			}
+		}
+	}
+}
+
+void PlotSeries::drawStrip(RefPtr<Context> ctx, const Rect &area, double step, size_t from) {
+	if (from + 1 >= size()) return;
+
+	StageTimer timer(Profiler::STAGE_AUTOSCALE);
+
+	double scale, offset;
+	getScale(area, &scale, &offset);
+
+	timer.next(Profiler::STAGE_PATH);
+	ctx->set_source_rgb(color.red, color.green, color.blue); /* set series color */
+
+	/* newest sample at the right border */
+	double x = area.x + area.width - (size() - 1 - from) * step;
+
+	ctx->move_to(x, offset - (*this)[from] * scale);
+	for (size_t i = from + 1; i < size(); i++) {
+		x += step;
+		ctx->line_to(x, offset - (*this)[i] * scale);
+	}
+
+	timer.next(Profiler::STAGE_STROKE);
+	ctx->stroke();
+}
+
+void PlotSeries::drawHistory(RefPtr<Context> ctx, const Rect &area, double from, double to) {
+	unsigned long long n = history.size();
+	unsigned long long window = n - size(); /* index of the oldest sample in the ring */
+	unsigned long long first = (from > 0) ? (unsigned long long) from : 0;
+	unsigned long long last = (to < n) ? (unsigned long long) ceil(to) : n;
+
+	if (first >= last) return;
+
+	double spp = (to - from) / area.width; /* samples per pixel */
+	double scale, offset;
+
+	StageTimer timer(Profiler::STAGE_AUTOSCALE);
+
+	int level = history.select(spp, first);
+	if (level < 0 && first < window) { /* single samples are gone */
+		level = history.select(history.getFactor(), first);
+		if (level < 0) first = window;
+	}
+
+	if (first >= last) return;
+
+	if (level < 0) {
+		double min = INFINITY, max = -INFINITY;
+
+		for (unsigned long long i = first; i < last; i++) {
+			double v = (*this)[i - window];
+			if (v < min) min = v;
+			if (v > max) max = v;
+		}
+
+		getScale(area, min, max, &scale, &offset);
+
+		timer.next(Profiler::STAGE_PATH);
+		ctx->set_source_rgb(color.red, color.green, color.blue);
+		ctx->move_to(area.x + (first - from) / spp, offset - (*this)[first - window] * scale);
+		for (unsigned long long i = first + 1; i < last; i++)
+			ctx->line_to(area.x + (i - from) / spp, offset - (*this)[i - window] * scale);
+
+		timer.next(Profiler::STAGE_STROKE);
+		ctx->stroke();
+
+		return;
+	}
+
+	double bucket = history.getBucketSize(level);
+	double start = history.get(level, first, last, buckets);
+
+	if (buckets.empty()) return;
+
+	double min = buckets[0].min, max = buckets[0].max;
+	for (size_t i = 1; i < buckets.size(); i++) {
+		if (buckets[i].min < min) min = buckets[i].min;
+		if (buckets[i].max > max) max = buckets[i].max;
+	}
+
+	getScale(area, min, max, &scale, &offset);
+
+	timer.next(Profiler::STAGE_PATH);
+
+	/* bucket centers */
+	double x = area.x + (start + bucket / 2 - from) / spp;
+	double dx = bucket / spp;
+
+	/* min/max band */
+	ctx->set_source_rgba(color.red, color.green, color.blue, 0.35);
+	ctx->move_to(x, offset - buckets[0].max * scale);
+	for (size_t i = 1; i < buckets.size(); i++)
+		ctx->line_to(x + i * dx, offset - buckets[i].max * scale);
+	for (size_t i = buckets.size(); i-- > 0; )
+		ctx->line_to(x + i * dx, offset - buckets[i].min * scale);
+	ctx->close_path();
+
+	timer.next(Profiler::STAGE_STROKE);
+	ctx->fill();
+
+	/* mean */
+	timer.next(Profiler::STAGE_PATH);
+	ctx->set_source_rgb(color.red, color.green, color.blue);
+	ctx->move_to(x, offset - buckets[0].mean * scale);
+	for (size_t i = 1; i < buckets.size(); i++)
+		ctx->line_to(x + i * dx, offset - buckets[i].mean * scale);
+
+	timer.next(Profiler::STAGE_STROKE);
 	ctx->stroke();
 }
 
 Plot::Plot(int width, int height)
-  : width(width), height(height)
+  : target(new WindowTarget("Frontend", width, height)), width(width), height(height)
 {
-	window = XWindow::create("Frontend", 1, 1, width, height);
-	surface = XlibSurface::create(window->getDisplay(), window->getWindow(), window->getVisual(), width, height);
+	init();
+}
+
+Plot::Plot(RenderTarget *target)
+  : target(target), width(target->getWidth()), height(target->getHeight())
+{
+	init();
+}
+
+void Plot::init() {
+	Color black = { 0, 0, 0 };
+	Color green = { 0, 0.7, 0.1 };
+
+	background = black;
+	axes = green;
+	antialias = ANTIALIAS_SUBPIXEL;
+
+	aliased = false;
+	coarse = 1;
+	focused = !getWindow(); /* until the first FocusIn */
+	hud = false;
+
+	chromeValid = false;
+	invalid = true;
+	revision = 0;
+
+	damage.x = damage.y = damage.width = damage.height = 0;
+	exposed = damage;
+
+	repainted = presented = 0;
+	repaintedTotal = presentedTotal = 0;
+
+	mode = MODE_FULL;
+	stripStep = 2;
+	layerValid = false;
+
+	zoomed = false;
+	viewFrom = viewTo = 0;
+	dragging = false;
+	dragX = 0;
+	dragFrom = 0;
+
+	renderTime = presentTime = 0;
+
+	buffer = target->getBuffer();
+	chrome = ImageSurface::create(FORMAT_RGB24, width, height);
+}
+
+void Plot::resize(int w, int h) {
+	if (w == width && h == height) return;
+
+	width = w;
+	height = h;
+
+	target->resize(width, height);
+	buffer = target->getBuffer();
+	chrome = ImageSurface::create(FORMAT_RGB24, width, height);
+	chromeValid = false;
+	invalid = true;
+}
+
+void Plot::setTheme(Color bg, Color fg) {
+	background = bg;
+	axes = fg;
+	chromeValid = false;
+	invalid = true;
+}
+
+void Plot::setMode(enum Mode m, int step) {
+	mode = m;
+	stripStep = step;
+	layerValid = false;
+	invalid = true;
+}
+
+void Plot::setAntialias(Antialias aa) {
+	antialias = aa;
+	chromeValid = false;
+	layerValid = false;
+	invalid = true;
+}
+
+void Plot::degrade(bool a, double c) {
+	if (a == aliased && c == coarse) return;
+
+	aliased = a;
+	coarse = c;
+	layerValid = false;
+	invalid = true;
+}
+
+void Plot::setHud(bool h) {
+	if (h) Profiler::setEnabled(true);
+
+	hud = h;
+	invalidate(getHudArea());
+}
+
+void Plot::setView(double from, double to) {
+	zoomed = true;
+	viewFrom = from;
+	viewTo = to;
+	invalid = true;
+}
+
+void Plot::resetView() {
+	zoomed = false;
+	dragging = false;
+	layerValid = false;
+	invalid = true;
+}
+
+void Plot::zoom(double factor, int x) {
+	Rect area = getArea();
+
+	if (!zoomed) {
+		if (series.empty()) return;
+
+		/* start with the range of the live view */
+		PlotSeries *s = series.front();
+		viewFrom = (double) s->getHistory().size() - s->size();
+		viewTo = viewFrom + (s->capacity() > 1 ? s->capacity() - 1 : 1);
+	}
+
+	double rel = (x - area.x) / area.width;
+	if (rel < 0) rel = 0;
+	if (rel > 1) rel = 1;
+
+	/* keep the sample under the pointer in place */
+	double span = viewTo - viewFrom;
+	double pivot = viewFrom + rel * span;
+
+	span *= factor;
+	if (span < MIN_VIEW) span = MIN_VIEW;
+
+	setView(pivot - rel * span, pivot + (1 - rel) * span);
 }
 
 void Plot::draw() {
-	RefPtr<Context> ctx = Context::create(surface);
-	ctx->set_antialias(ANTIALIAS_SUBPIXEL);
+	Rect all = { 0, 0, (double) width, (double) height };
+
+	damage = all;
+	render();
+}
+
+void Plot::render() {
+	double start = Clock::now();
+	RefPtr<Context> ctx = Context::create(buffer);
+
+	{
+		StageTimer timer(Profiler::STAGE_COMPOSITE);
+
+		if (!chromeValid) drawChrome();
+
+		/* nothing outside the damage changed */
+		ctx->rectangle(damage.x, damage.y, damage.width, damage.height);
+		ctx->clip();
+
+		/* cached background */
+		ctx->set_operator(OPERATOR_SOURCE);
+		ctx->set_source(chrome, 0, 0);
+		ctx->paint();
+	}
+
+	ctx->set_operator(OPERATOR_OVER);
+	ctx->set_antialias(aliased ? ANTIALIAS_NONE : antialias);
+
+	Rect area = getArea();
+	if (zoomed) {
+		for (std::list<PlotSeries *>::iterator it = series.begin(); it != series.end(); it++) {
+			(*it)->drawHistory(ctx, area, viewFrom, viewTo);
+		}
+	}
+	else if (mode == MODE_STRIP) {
+		drawStrip(area);
+
+		StageTimer timer(Profiler::STAGE_COMPOSITE);
+		ctx->set_source(layer, area.x - MARGIN, area.y - MARGIN);
+		ctx->paint();
+	}
+	else {
+		for (std::list<PlotSeries *>::iterator it = series.begin(); it != series.end(); it++) {
+			PlotSeries *s = *it;
+			Rect bounds = s->getBounds(area);
+
+			/* series outside the damage are unchanged in the buffer */
+			if (bounds.x < damage.x + damage.width && damage.x < bounds.x + bounds.width &&
+			    bounds.y < damage.y + damage.height && damage.y < bounds.y + bounds.height)
+				s->draw(ctx, area, coarse);
+
+			FrameState st = { s->getPushed(), s->getRemoved(), bounds };
+			frameState[s] = st;
+		}
+
+		if (frameState.size() > series.size()) { /* forget removed series */
+			std::map<PlotSeries *, FrameState> current;
+
+			for (std::list<PlotSeries *>::iterator it = series.begin(); it != series.end(); it++)
+				current[*it] = frameState[*it];
+
+			frameState.swap(current);
+		}
+	}
+
+	{
+		StageTimer timer(Profiler::STAGE_COMPOSITE);
+
+		if (hud) drawHud(ctx);
+		buffer->flush();
+	}
+
+	renderTime = Clock::now() - start;
+
+	repainted = (unsigned long) (damage.width * damage.height);
+	repaintedTotal += repainted;
+
+	revision = getRevision();
+	invalid = false;
+
+	Rect shown = unite(damage, exposed);
+	damage.width = exposed.width = 0;
+
+	present(shown);
+}
+
+void Plot::present() {
+	Rect all = { 0, 0, (double) width, (double) height };
+
+	exposed.width = 0;
+	present(all);
+}
+
+void Plot::present(const Rect &rect) {
+	StageTimer timer(Profiler::STAGE_PRESENT);
+	double start = Clock::now();
+
+	target->present((int) rect.x, (int) rect.y, (int) rect.width, (int) rect.height);
+
+	presentTime = Clock::now() - start;
+
+	presented = (unsigned long) (rect.width * rect.height);
+	presentedTotal += presented;
+}
+
+bool Plot::update() {
+	track();
+
+	/* new timings with every frame, but no frames for them alone */
+	if (hud && damage.width > 0)
+		damage = unite(damage, getHudArea());
+
+	if (damage.width > 0) {
+		render();
+		return true;
+	}
+	else if (exposed.width > 0) {
+		Rect shown = exposed;
+
+		exposed.width = 0;
+		present(shown);
+		return true;
+	}
+
+	return false;
+}
+
+void Plot::invalidate(const Rect &rect) {
+	damage = unite(damage, rect);
+}
+
+bool Plot::isDirty() const {
+	return invalid || revision != getRevision() || damage.width > 0 || exposed.width > 0;
+}
+
+void Plot::track() {
+	Rect all = { 0, 0, (double) width, (double) height };
+	Rect area = getArea();
+
+	if (invalid) {
+		damage = all;
+	}
+	else if (revision == getRevision()) {
+		return;
+	}
+	else if (zoomed) {
+		damage = all; /* the strokes of the history are not bounded */
+	}
+	else if (mode == MODE_STRIP) {
+		Rect layerArea = { area.x - MARGIN, area.y - MARGIN, area.width + 2*MARGIN, area.height + 2*MARGIN };
+		damage = unite(damage, layerArea);
+	}
+	else {
+		size_t known = 0;
+
+		/* the old and the new position of each changed series */
+		for (std::list<PlotSeries *>::iterator it = series.begin(); it != series.end(); it++) {
+			PlotSeries *s = *it;
+			std::map<PlotSeries *, FrameState>::iterator st = frameState.find(s);
+
+			if (st == frameState.end()) {
+				damage = unite(damage, s->getBounds(area));
+			}
+			else {
+				known++;
+
+				if (st->second.pushed != s->getPushed() || st->second.removed != s->getRemoved()) {
+					damage = unite(damage, st->second.bounds);
+					damage = unite(damage, s->getBounds(area));
+				}
+			}
+		}
+
+		/* removed series */
+		if (known < frameState.size()) {
+			for (std::map<PlotSeries *, FrameState>::iterator st = frameState.begin(); st != frameState.end(); st++)
+				damage = unite(damage, st->second.bounds);
+		}
+	}
+}
+
+Rect Plot::unite(const Rect &a, const Rect &b) const {
+	if (b.width <= 0 || b.height <= 0) return a;
+
+	/* whole pixels, so the clip needs no antialiasing */
+	double x0 = floor(b.x), y0 = floor(b.y);
+	double x1 = ceil(b.x + b.width), y1 = ceil(b.y + b.height);
+
+	if (a.width > 0 && a.height > 0) {
+		if (a.x < x0) x0 = a.x;
+		if (a.y < y0) y0 = a.y;
+		if (a.x + a.width > x1) x1 = a.x + a.width;
+		if (a.y + a.height > y1) y1 = a.y + a.height;
+	}
+
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > width) x1 = width;
+	if (y1 > height) y1 = height;
+
+	Rect r = { x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0 };
+	return r;
+}
+
+void Plot::handleEvent(XEvent *e) {
+	switch (e->type) {
+		case Expose: {
+			Rect rect = { (double) e->xexpose.x, (double) e->xexpose.y,
+				(double) e->xexpose.width, (double) e->xexpose.height };
+
+			exposed = unite(exposed, rect);
+			break;
+		}
+
+		case FocusIn:
+			focused = true;
+			break;
+
+		case FocusOut:
+			focused = false;
+			break;
+
+		case ConfigureNotify:
+			resize(e->xconfigure.width, e->xconfigure.height);
+			break;
+
+		case ButtonPress:
+			switch (e->xbutton.button) {
+				case Button1: /* start panning */
+					if (!zoomed) zoom(1, e->xbutton.x);
+					dragging = true;
+					dragX = e->xbutton.x;
+					dragFrom = viewFrom;
+					break;
+
+				case Button3: resetView(); break;
+				case Button4: zoom(0.8, e->xbutton.x); break; /* wheel up */
+				case Button5: zoom(1.25, e->xbutton.x); break;
+			}
+			break;
+
+		case MotionNotify:
+			if (dragging) {
+				double span = viewTo - viewFrom;
+				double from = dragFrom - (e->xmotion.x - dragX) * span / getArea().width;
+
+				setView(from, from + span);
+			}
+			break;
+
+		case ButtonRelease:
+			if (e->xbutton.button == Button1) dragging = false;
+			break;
+	}
+}
+
+unsigned long long Plot::getRevision() const {
+	unsigned long long rev = series.size();
+
+	for (std::list<PlotSeries *>::const_iterator it = series.begin(); it != series.end(); it++) {
+		rev += (*it)->getPushed() + (*it)->getRemoved();
+	}
+
+	return rev;
+}
+
+void Plot::drawChrome() {
+	RefPtr<Context> ctx = Context::create(chrome);
+	ctx->set_antialias(antialias);
 
 	/* background */
-	ctx->set_source_rgb(0, 0, 0); /* black */
+	ctx->set_source_rgb(background.red, background.green, background.blue);
 	ctx->paint();
 
-	ctx->set_source_rgb(0, 0.7, 0.1); /* axis & tick color */
+	ctx->set_source_rgb(axes.red, axes.green, axes.blue); /* axis & tick color */
 	drawAxes(ctx);
 	drawTicks(ctx);
 
+	chrome->flush();
+	chromeValid = true;
+}
+
+void Plot::drawStrip(const Rect &area) {
+	int w = (int) ceil(area.width) + 2*MARGIN;
+	int h = (int) ceil(area.height) + 2*MARGIN;
+	Rect inner = { MARGIN, MARGIN, area.width, area.height };
+
+	if (!layer || layer->get_width() != w || layer->get_height() != h) {
+		layer = ImageSurface::create(FORMAT_ARGB32, w, h);
+		scratch = ImageSurface::create(FORMAT_ARGB32, w, h);
+		layerValid = false;
+	}
+
+	/* we can only scroll if all series got the same number of new samples
+	 * and their autoscale did not change since the last frame */
+	bool incremental = layerValid && stripState.size() == series.size();
+	long shift = -1;
+
+	for (std::list<PlotSeries *>::iterator it = series.begin(); incremental && it != series.end(); it++) {
+		PlotSeries *s = *it;
+		std::map<PlotSeries *, StripState>::iterator st = stripState.find(s);
+
+		if (st == stripState.end() || s->empty() ||
+		    st->second.removed != s->getRemoved() ||
+		    st->second.min != s->min() || st->second.max != s->max()) {
+			incremental = false;
+		}
+		else {
+			long n = s->getPushed() - st->second.pushed;
+
+			if (shift >= 0 && n != shift)
+				incremental = false;
+
+			shift = n;
+		}
+	}
+
+	if (shift < 0) shift = 0;
+
+	int dx = shift * stripStep;
+	if (dx >= area.width) incremental = false;
+
+	if (incremental && shift == 0) return; /* nothing new */
+
+	RefPtr<Context> ctx;
+
+	if (incremental) {
+		StageTimer timer(Profiler::STAGE_COMPOSITE);
+
+		/* scroll the rendered series to the left */
+		ctx = Context::create(scratch);
+		ctx->set_operator(OPERATOR_SOURCE);
+		ctx->set_source(layer, -dx, 0);
+		ctx->paint();
+
+		RefPtr<ImageSurface> tmp = layer;
+		layer = scratch;
+		scratch = tmp;
+
+		/* restrict drawing to the new part and the overlapping samples */
+		int x = MARGIN + (int) area.width - dx - OVERLAP * stripStep;
+
+		ctx = Context::create(layer);
+		ctx->rectangle(x, 0, w - x, h);
+		ctx->clip();
+	}
+	else {
+		ctx = Context::create(layer);
+		stripState.clear();
+	}
+
+	ctx->set_operator(OPERATOR_CLEAR);
+	ctx->paint();
+
+	ctx->set_operator(OPERATOR_OVER);
+	ctx->set_antialias(aliased ? ANTIALIAS_NONE : antialias);
+
 	for (std::list<PlotSeries *>::iterator it = series.begin(); it != series.end(); it++) {
-		(*it)->draw(ctx);
+		PlotSeries *s = *it;
+		size_t from = 0;
+
+		if (incremental && s->size() > (size_t) shift + OVERLAP + 1)
+			from = s->size() - 1 - shift - OVERLAP - 1;
+
+		s->drawStrip(ctx, inner, stripStep, from);
+
+		StripState st = { s->getPushed(), s->getRemoved(), 0, 0 };
+		if (!s->empty()) {
+			st.min = s->min();
+			st.max = s->max();
+		}
+		stripState[s] = st;
 	}
+
+	layer->flush();
+	layerValid = true;
+}
+
+Rect Plot::getArea() const {
+	Rect area = { PADDING, PADDING, width - 2.0*PADDING, height - 2.0*PADDING };
+	return area;
 }
 
 void Plot::drawAxes(RefPtr<Context> ctx) {
@@ -83,6 +980,41 @@ void Plot::drawAxes(RefPtr<Context> ctx) {
 	ctx->stroke();
 }
 
+Rect Plot::getHudArea() const {
+	Rect r = { (double) width - PADDING - HUD_WIDTH, PADDING, HUD_WIDTH, HUD_LINE * (Profiler::STAGES + 1) + 6.0 };
+	return r;
+}
+
+void Plot::drawHud(RefPtr<Context> ctx) {
+	Rect r = getHudArea();
+	char line[64];
+
+	ctx->save();
+
+	ctx->set_source_rgba(background.red, background.green, background.blue, 0.8);
+	ctx->rectangle(r.x, r.y, r.width, r.height);
+	ctx->fill();
+
+	ctx->set_source_rgb(axes.red, axes.green, axes.blue);
+	ctx->select_font_face("monospace", FONT_SLANT_NORMAL, FONT_WEIGHT_NORMAL);
+	ctx->set_font_size(10);
+
+	snprintf(line, sizeof(line), "%-9s %6s %6s %6s", "ms", "p50", "p99", "max");
+	ctx->move_to(r.x + 4, r.y + HUD_LINE);
+	ctx->show_text(line);
+
+	for (int s = 0; s < Profiler::STAGES; s++) {
+		Profiler::Stats st = Profiler::getStats((enum Profiler::Stage) s);
+
+		snprintf(line, sizeof(line), "%-9s %6.2f %6.2f %6.2f", Profiler::getName((enum Profiler::Stage) s),
+			st.p50 * 1e3, st.p99 * 1e3, st.max * 1e3);
+		ctx->move_to(r.x + 4, r.y + HUD_LINE * (s + 2));
+		ctx->show_text(line);
+	}
+
+	ctx->restore();
+}
+
 void Plot::drawTicks(RefPtr<Context> ctx) {
 	int ticks = 20;
 	int intv_x = (width-2*PADDING)/ticks;
@@ -104,5 +1036,6 @@ void Plot::drawTicks(RefPtr<Context> ctx) {
 }
 
 Plot::~Plot() {
-
+	buffer.clear();
+	delete target;
 }
@@ -2,10 +2,18 @@
 #define _PLOT_H_
 
 #include <list>
+#include <map>
+#include <vector>
 #include <cairomm/cairomm.h>
-#include <cairomm/xlib_surface.h>
 
 #include "XWindow.h"
+#include "RingBuffer.h"
+#include "SlidingExtrema.h"
+#include "Decimator.h"
+#include "Pyramid.h"
+#include "Transform.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
 
 using namespace Cairo;
 
@@ -13,14 +21,119 @@ struct Color {
 	double red, green, blue, alpha;
 };
 
-class PlotSeries : public std::list<double> {
+struct Rect {
+	double x, y, width, height;
+};
+
+class PlotSeries : protected RingBuffer<double> {
 
   public:
 	Color color;
 	enum Style { STYLE_LINE, STYLE_SPLINE, STYLE_SCATTER } style;
+	enum Decimation { DECIMATION_NONE, DECIMATION_M4, DECIMATION_LTTB } decimation;
+
+	/* draw thin solid lines directly into the pixels, see Rasterizer */
+	enum Raster { RASTER_NONE, RASTER_ALIASED, RASTER_ANTIALIASED } raster;
+
+	/* stroke, the raster is only used for a width up to 1 px without dashes */
+	double lineWidth;
+	std::vector<double> dashes;
+
+	/* marker of STYLE_SCATTER in pixels */
+	double markerRadius;
+
+	PlotSeries(enum Style style, Color color, size_t capacity = 1024);
+
+	/**
+	 * @param coarse	Pixels per decimation bucket, more than 1 to save time
+	 */
+	void draw(RefPtr<Context> ctx, const Rect &area, double coarse = 1);
+
+	/**
+	 * Pixels draw() covers, including the stroke or markers
+	 */
+	Rect getBounds(const Rect &area) const;
+
+	/**
+	 * Draw right-aligned with a fixed distance between samples (strip chart)
+	 *
+	 * @param step	Distance of two samples in pixels
+	 * @param from	Index of the first sample to draw
+	 */
+	void drawStrip(RefPtr<Context> ctx, const Rect &area, double step, size_t from = 0);
+
+	/**
+	 * Draw a range of the history, autoscaled to its extrema
+	 *
+	 * Renders from the pyramid level closest to one bucket per pixel as
+	 * a min/max band with the mean line, or the single samples if they
+	 * are still in the window and not denser than that.
+	 *
+	 * @param from	Index of the first sample since the start of the series
+	 * @param to	Index after the last sample
+	 */
+	void drawHistory(RefPtr<Context> ctx, const Rect &area, double from, double to);
+
+	void push_back(double value);
+	void pop_front();
+	void clear();
+
+	double front() const { return RingBuffer<double>::front(); }
+	double back() const { return RingBuffer<double>::back(); }
+	double operator[](size_t i) const { return RingBuffer<double>::operator[](i); }
+
+	using RingBuffer<double>::const_iterator;
+	using RingBuffer<double>::begin;
+	using RingBuffer<double>::end;
+	using RingBuffer<double>::spans;
+	using RingBuffer<double>::size;
+	using RingBuffer<double>::capacity;
+	using RingBuffer<double>::empty;
+	using RingBuffer<double>::full;
+
+	/**
+	 * Extrema of the current window for autoscale (only valid if not empty)
+	 */
+	double min() const { return extrema.min(); }
+	double max() const { return extrema.max(); }
+
+	const Pyramid & getHistory() const { return history; }
 
-	PlotSeries(enum Style style, Color color);
-	void draw(RefPtr<Context> ctx);
+	/* modification counters to detect changes between frames */
+	unsigned long long getPushed() const { return pushed; }
+	unsigned long long getRemoved() const { return removed; }
+
+  protected:
+	SlidingExtrema extrema;
+	Pyramid history;
+
+	unsigned long long pushed, removed;
+
+	/* autoscale: y = offset - value * scale */
+	void getScale(const Rect &area, double *scale, double *offset) const;
+	static void getScale(const Rect &area, double min, double max, double *scale, double *offset);
+
+	std::vector<Point> points; /* decimated points, reused between frames */
+	/* pixel coordinates of the path */
+	static const size_t BLOCK = 1024;
+	Point coords[BLOCK];
+
+	std::vector<uint32_t> stamped; /* marker positions of the frame, reused */
+
+	/**
+	 * Feed the points to a path builder: cairo, a spline or a Rasterizer
+	 *
+	 * @param decimate	Reduce dense series to the visible points (lines only)
+	 */
+	template <class Path>
+	void trace(Path &path, const Rect &area, double step, double offset, double scale, bool decimate, double coarse = 1);
+
+	/**
+	 * Append the first n coordinates to the path, start a new one if start
+	 */
+	template <class Path>
+	void emit(Path &path, size_t n, bool start);
+	std::vector<Bucket> buckets; /* of the history, reused between frames */
 };
 
 class Plot {
@@ -28,23 +141,216 @@ class Plot {
 	friend class PlotSeries;
 
   public:
+	enum Mode {
+		MODE_FULL,	/* redraw all series each frame */
+		MODE_STRIP	/* scroll and only draw new samples */
+	};
+
+	/**
+	 * Plot in its own X window
+	 */
 	Plot(int width = 400, int height = 300);
+
+	/**
+	 * Plot into any target, e.g. offscreen (takes ownership)
+	 */
+	Plot(RenderTarget *target);
 	virtual ~Plot();
 
+	/**
+	 * Render and present the whole plot
+	 */
 	void draw();
 
+	/**
+	 * Pass the whole back buffer to the target
+	 */
+	void present();
+
+	/**
+	 * Render and present only what changed since the last frame
+	 *
+	 * The damage of a frame is the union of the areas covered by changed
+	 * series (before and after the change), exposed parts of the window and
+	 * rectangles passed to invalidate(). Rendering is clipped to its bounding
+	 * box, which is also the only part presented. Exposed areas alone are
+	 * presented without rendering.
+	 *
+	 * @return true if anything was sent to the window
+	 */
+	bool update();
+
+	/**
+	 * Mark a rectangle for repainting by the next update(), e.g. an overlay
+	 */
+	void invalidate(const Rect &rect);
+
+	/* anything for update() to do */
+	bool isDirty() const;
+
+	/**
+	 * Handle an X event for this plot's window
+	 */
+	void handleEvent(XEvent *e);
+
+	/* empty for headless targets */
+	RefPtr<XWindow> getWindow() const { return target->getWindow(); }
+	RenderTarget * getTarget() const { return target; }
+
+	/**
+	 * Change the size of the plot (invalidates the cached chrome)
+	 */
+	void resize(int width, int height);
+
+	/**
+	 * Change the colors of background and axes (invalidates the cached chrome)
+	 */
+	void setTheme(Color background, Color axes);
+
+	/**
+	 * Select the render mode
+	 *
+	 * The strip chart mode requires all series to be appended in lockstep.
+	 * It falls back to a full redraw whenever the autoscale changes.
+	 *
+	 * @param step	Distance of two samples in pixels (MODE_STRIP only)
+	 */
+	void setMode(enum Mode mode, int step = 2);
+
+	/**
+	 * Select the antialiasing of the series and the chrome
+	 */
+	void setAntialias(Antialias antialias);
+
+	/**
+	 * Reduce the rendering cost under load, see Governor
+	 *
+	 * @param aliased	Draw the series without antialiasing
+	 * @param coarse	Pixels per decimation bucket (1 for full resolution)
+	 */
+	void degrade(bool aliased, double coarse);
+
+	/**
+	 * Show the stage timings of the Profiler in the upper right corner
+	 */
+	void setHud(bool hud);
+
+	/* has the input focus, always true for headless targets */
+	bool isFocused() const { return focused; }
+
+	/**
+	 * Show a range of the history instead of the current window
+	 *
+	 * The range is given in samples since the start of the series.
+	 * Mouse: wheel zooms around the pointer, dragging with the left
+	 * button pans, the right button returns to the live view.
+	 */
+	void setView(double from, double to);
+	void resetView();
+	bool isZoomed() const { return zoomed; }
+
+	/* duration of the last render and present step in seconds */
+	double getRenderTime() const { return renderTime; }
+	double getPresentTime() const { return presentTime; }
+
+	/* pixels rendered and presented in the last frame, and since the start */
+	unsigned long getRepaintedPixels() const { return repainted; }
+	unsigned long getPresentedPixels() const { return presented; }
+	unsigned long long getRepaintedTotal() const { return repaintedTotal; }
+	unsigned long long getPresentedTotal() const { return presentedTotal; }
+
 	std::list<PlotSeries *> series;
 
   protected:
-	RefPtr<XWindow> window;
-	RefPtr<Surface> surface;
+	RenderTarget *target;
+	RefPtr<ImageSurface> buffer; /* client-side back buffer of the target */
+	RefPtr<ImageSurface> chrome; /* prerendered background, axes and ticks */
+
+	bool chromeValid;
+	Color background, axes;
+	Antialias antialias;
+
+	/* set by the Governor */
+	bool aliased;
+	double coarse;
+	bool focused;
+
+	bool hud;
+
+	bool invalid;
+	unsigned long long revision; /* of the series in the last frame */
+
+	/* pending areas in pixels, empty if width is 0 */
+	Rect damage; /* to render and present */
+	Rect exposed; /* to present */
+
+	/* series in the last frame of the full mode */
+	struct FrameState {
+		unsigned long long pushed, removed;
+		Rect bounds;
+	};
+
+	std::map<PlotSeries *, FrameState> frameState;
+
+	unsigned long repainted, presented;
+	unsigned long long repaintedTotal, presentedTotal;
+
+	/* strip chart mode */
+	struct StripState {
+		unsigned long long pushed, removed;
+		double min, max;
+	};
+
+	enum Mode mode;
+	int stripStep;
+	bool layerValid;
+	RefPtr<ImageSurface> layer, scratch; /* rendered series and scroll target */
+	std::map<PlotSeries *, StripState> stripState;
+
+	/* history view */
+	bool zoomed;
+	double viewFrom, viewTo;
+	bool dragging;
+	int dragX;
+	double dragFrom;
+
+	double renderTime, presentTime;
 
 	int width, height;
 
+	Rect getArea() const;
+	unsigned long long getRevision() const;
+
+	void init();
+
+	/**
+	 * Add the areas changed since the last frame to the damage
+	 */
+	void track();
+
+	/**
+	 * Render the damage, then present it with the exposed areas
+	 */
+	void render();
+	void present(const Rect &rect);
+
+	/* bounding box of both in whole pixels within the window */
+	Rect unite(const Rect &a, const Rect &b) const;
+
+	void drawChrome();
+	void drawStrip(const Rect &area);
 	void drawAxes(RefPtr<Context> ctx);
 	void drawTicks(RefPtr<Context> ctx);
+	void drawHud(RefPtr<Context> ctx);
+	Rect getHudArea() const;
+
+	void zoom(double factor, int x);
 
 	static const int PADDING = 20;
+	static const int MARGIN = 2; /* around the strip layer for line width */
+	static const int OVERLAP = 3; /* samples redrawn before the new ones */
+	static const int MIN_VIEW = 16; /* samples */
+	static const int HUD_WIDTH = 190, HUD_LINE = 12; /* pixels */
 };
 
 #endif /* _PLOT_H_ */
@@ -0,0 +1,77 @@
+#include <algorithm>
+
+#include "Profiler.h"
+
+bool Profiler::enabled = false;
+double Profiler::current[STAGES];
+float Profiler::window[STAGES][WINDOW];
+unsigned long Profiler::frames = 0;
+
+void Profiler::setEnabled(bool e) {
+	enabled = e;
+
+	for (int s = 0; s < STAGES; s++)
+		current[s] = 0;
+}
+
+void Profiler::frame() {
+	if (!enabled) return;
+
+	for (int s = 0; s < STAGES; s++) {
+		window[s][frames % WINDOW] = (float) current[s];
+		current[s] = 0;
+	}
+
+	frames++;
+}
+
+Profiler::Stats Profiler::getStats(enum Stage stage) {
+	Stats stats = { 0, 0, 0 };
+	size_t n = (frames < (unsigned long) WINDOW) ? frames : WINDOW;
+
+	if (n == 0) return stats;
+
+	/* the window is small, a sorted copy is cheap enough for each frame of the HUD */
+	float sorted[WINDOW];
+	std::copy(window[stage], window[stage] + n, sorted);
+	std::sort(sorted, sorted + n);
+
+	stats.p50 = sorted[n / 2];
+	stats.p99 = sorted[(n * 99) / 100];
+	stats.max = sorted[n - 1];
+
+	return stats;
+}
+
+const char * Profiler::getName(enum Stage stage) {
+	switch (stage) {
+		case STAGE_INGEST:    return "ingest";
+		case STAGE_AUTOSCALE: return "autoscale";
+		case STAGE_PATH:      return "path";
+		case STAGE_STROKE:    return "stroke";
+		case STAGE_COMPOSITE: return "composite";
+		case STAGE_PRESENT:   return "present";
+		default:              return "unknown";
+	}
+}
+
+void Profiler::dump(FILE *out, bool json) {
+	if (json)
+		fprintf(out, "{\"frames\":%lu,\"window\":%d,\"stages\":{", frames, WINDOW);
+	else
+		fprintf(out, "stage,frames,p50_ms,p99_ms,max_ms\n");
+
+	for (int s = 0; s < STAGES; s++) {
+		Stats st = getStats((enum Stage) s);
+
+		if (json)
+			fprintf(out, "%s\"%s\":{\"p50_ms\":%.4f,\"p99_ms\":%.4f,\"max_ms\":%.4f}", s ? "," : "",
+				getName((enum Stage) s), st.p50 * 1e3, st.p99 * 1e3, st.max * 1e3);
+		else
+			fprintf(out, "%s,%lu,%.4f,%.4f,%.4f\n", getName((enum Stage) s), frames,
+				st.p50 * 1e3, st.p99 * 1e3, st.max * 1e3);
+	}
+
+	if (json)
+		fprintf(out, "}}\n");
+}
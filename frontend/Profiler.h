@@ -0,0 +1,99 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdio.h>
+
+#include "Clock.h"
+
+/**
+ * Time spent per frame in the stages of the frontend
+ *
+ * The stages add their time to the current frame, frame() closes it. The
+ * statistics cover a rolling window of the last frames. Disabled, the
+ * instrumentation costs a test of a flag per stage and series.
+ */
+class Profiler {
+
+  public:
+	enum Stage {
+		STAGE_INGEST,		/* samples from the acquisition into the series */
+		STAGE_AUTOSCALE,	/* scale and offset of the series */
+		STAGE_PATH,		/* decimation, transformation, path building */
+		STAGE_STROKE,		/* stroking and filling, direct rasterization */
+		STAGE_COMPOSITE,	/* background, strip layer and overlays */
+		STAGE_PRESENT,		/* back buffer to the window */
+		STAGES
+	};
+
+	/* in seconds, over the window */
+	struct Stats {
+		double p50, p99, max;
+	};
+
+	static void setEnabled(bool enabled);
+	static bool isEnabled() { return enabled; }
+
+	static void add(enum Stage stage, double time) { current[stage] += time; }
+
+	/**
+	 * Close the current frame
+	 */
+	static void frame();
+
+	static Stats getStats(enum Stage stage);
+	static unsigned long getFrames() { return frames; }
+	static const char * getName(enum Stage stage);
+
+	/**
+	 * Write the statistics of all stages as CSV or JSON
+	 */
+	static void dump(FILE *out, bool json);
+
+	static const int WINDOW = 256; /* frames */
+
+  protected:
+	static bool enabled;
+	static double current[STAGES];
+	static float window[STAGES][WINDOW];
+	static unsigned long frames;
+};
+
+/**
+ * Adds the time until its destruction or next() to a stage, if profiling
+ */
+class StageTimer {
+
+  public:
+	StageTimer(enum Profiler::Stage stage)
+	  : stage(stage), start(Profiler::isEnabled() ? Clock::now() : 0)
+	{ }
+
+	~StageTimer() {
+		if (start > 0) Profiler::add(stage, Clock::now() - start);
+	}
+
+	/**
+	 * Continue with another stage
+	 */
+	void next(enum Profiler::Stage s) {
+		if (start > 0) {
+			double now = Clock::now();
+
+			Profiler::add(stage, now - start);
+			start = now;
+		}
+
+		stage = s;
+	}
+
+  protected:
+	enum Profiler::Stage stage;
+	double start;
+
+  private:
+	/* not copyable */
+	StageTimer(const StageTimer &);
+	StageTimer & operator=(const StageTimer &);
+};
+
+#endif /* _PROFILER_H_ */
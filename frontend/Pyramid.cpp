@@ -0,0 +1,140 @@
+#include <math.h>
+
+#include "Pyramid.h"
+
+Pyramid::Pyramid(size_t buckets, unsigned factor)
+  : buckets(buckets), factor(factor > 1 ? factor : 2), count(0), pending(MAX_LEVELS)
+{
+	clear();
+}
+
+Pyramid::~Pyramid() {
+	for (size_t k = 0; k < levels.size(); k++)
+		delete levels[k];
+}
+
+void Pyramid::push(double value) {
+	Pending *p = &pending[0];
+
+	count++;
+
+	if (p->parts == 0 || value < p->min) p->min = value;
+	if (p->parts == 0 || value > p->max) p->max = value;
+	p->sum += value;
+	p->samples++;
+	p->parts++;
+
+	/* carry complete buckets upwards */
+	for (unsigned k = 0; k < MAX_LEVELS && pending[k].parts == factor; k++) {
+		Pending &c = pending[k];
+		Bucket b = { c.min, c.max, c.sum / c.samples };
+
+		if (k == levels.size())
+			levels.push_back(new RingBuffer<Bucket>(buckets));
+
+		levels[k]->push_back(b);
+
+		if (k + 1 < MAX_LEVELS) {
+			Pending &n = pending[k + 1];
+
+			if (n.parts == 0 || c.min < n.min) n.min = c.min;
+			if (n.parts == 0 || c.max > n.max) n.max = c.max;
+			n.sum += c.sum;
+			n.samples += c.samples;
+			n.parts++;
+		}
+
+		c.sum = 0;
+		c.samples = 0;
+		c.parts = 0;
+	}
+}
+
+void Pyramid::clear() {
+	Pending empty = { 0, 0, 0, 0, 0 };
+
+	count = 0;
+
+	for (size_t k = 0; k < levels.size(); k++)
+		levels[k]->clear();
+
+	for (size_t k = 0; k < pending.size(); k++)
+		pending[k] = empty;
+}
+
+unsigned long long Pyramid::getBucketSize(unsigned level) const {
+	unsigned long long size = factor;
+
+	for (unsigned k = 0; k < level; k++)
+		size *= factor;
+
+	return size;
+}
+
+unsigned long long Pyramid::getFirst(unsigned level) const {
+	unsigned long long size = getBucketSize(level);
+
+	if (level >= levels.size())
+		return (count / size) * size; /* only the pending bucket */
+
+	return (count / size - levels[level]->size()) * size;
+}
+
+int Pyramid::select(double samplesPerBucket, unsigned long long from) const {
+	/* geometric middle between single samples and level 0 */
+	if (levels.empty() || samplesPerBucket < sqrt((double) factor))
+		return -1;
+
+	int level = (int) floor(log(samplesPerBucket) / log((double) factor) + 0.5) - 1;
+	int top = levels.size() - 1;
+
+	if (level > top) level = top;
+
+	/* finer levels may have evicted the start of the view */
+	while (level < top && getFirst(level) > from)
+		level++;
+
+	return level;
+}
+
+unsigned long long Pyramid::get(unsigned level, unsigned long long from, unsigned long long to, std::vector<Bucket> &out) const {
+	unsigned long long size = getBucketSize(level);
+	unsigned long long complete = count / size;
+	unsigned long long first = getFirst(level) / size;
+	unsigned long long end = (to + size - 1) / size;
+	unsigned long long begin = from / size;
+
+	out.clear();
+
+	if (begin < first) begin = first;
+
+	/* incomplete newest bucket, including the samples still pending below */
+	Pending p = { 0, 0, 0, 0, 0 };
+
+	for (unsigned k = 0; k <= level && k < MAX_LEVELS; k++) {
+		const Pending &q = pending[k];
+
+		if (q.samples == 0) continue;
+
+		if (p.samples == 0 || q.min < p.min) p.min = q.min;
+		if (p.samples == 0 || q.max > p.max) p.max = q.max;
+		p.sum += q.sum;
+		p.samples += q.samples;
+	}
+
+	unsigned long long last = p.samples ? complete + 1 : complete;
+
+	if (end > last) end = last;
+
+	for (unsigned long long i = begin; i < end; i++) {
+		if (i < complete) {
+			out.push_back((*levels[level])[i - first]);
+		}
+		else {
+			Bucket b = { p.min, p.max, p.sum / p.samples };
+			out.push_back(b);
+		}
+	}
+
+	return begin * size;
+}
@@ -0,0 +1,92 @@
+#ifndef _PYRAMID_H_
+#define _PYRAMID_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include "RingBuffer.h"
+
+/**
+ * Aggregate of consecutive samples
+ */
+struct Bucket {
+	double min, max, mean;
+};
+
+/**
+ * Multi-resolution min/max/mean summary of the whole history of a series
+ *
+ * Level k aggregates factor^(k+1) samples per bucket. Each level keeps the
+ * newest buckets in a ring, so the fine levels reach back less far than the
+ * coarse ones. Buckets are aligned to the sample index, push() is amortized
+ * O(1) and levels are only allocated once they receive their first bucket.
+ */
+class Pyramid {
+
+  public:
+	/**
+	 * @param buckets	Capacity of each level
+	 * @param factor	Reduction from one level to the next
+	 */
+	Pyramid(size_t buckets = 1 << 16, unsigned factor = 4);
+	~Pyramid();
+
+	void push(double value);
+	void clear();
+
+	/* samples pushed since the last clear() */
+	unsigned long long size() const { return count; }
+
+	unsigned getLevels() const { return levels.size(); }
+	unsigned getFactor() const { return factor; }
+
+	/**
+	 * Number of samples aggregated by a bucket of a level
+	 */
+	unsigned long long getBucketSize(unsigned level) const;
+
+	/**
+	 * Index of the oldest sample still covered by a level
+	 */
+	unsigned long long getFirst(unsigned level) const;
+
+	/**
+	 * Level closest to samplesPerBucket which still reaches back to sample from
+	 *
+	 * @return level or -1 if single samples are closer
+	 */
+	int select(double samplesPerBucket, unsigned long long from) const;
+
+	/**
+	 * Get the buckets of a level overlapping the samples [from, to)
+	 *
+	 * The newest bucket may be incomplete.
+	 *
+	 * @return Index of the first sample of the first bucket
+	 */
+	unsigned long long get(unsigned level, unsigned long long from, unsigned long long to, std::vector<Bucket> &out) const;
+
+  protected:
+	/* incomplete bucket of a level */
+	struct Pending {
+		double min, max, sum;
+		unsigned long long samples;
+		unsigned parts;		/* samples (level 0) or buckets of the level below */
+	};
+
+	size_t buckets;
+	unsigned factor;
+	unsigned long long count;
+
+	std::vector<RingBuffer<Bucket> *> levels;
+	std::vector<Pending> pending;
+
+	static const unsigned MAX_LEVELS = 16;
+
+  private:
+	/* not copyable */
+	Pyramid(const Pyramid &);
+	Pyramid & operator=(const Pyramid &);
+};
+
+#endif /* _PYRAMID_H_ */
@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "Rasterizer.h"
+
+Rasterizer::Rasterizer(unsigned char *data, int width, int height, int stride, bool antialias)
+  : data((uint32_t *) data), width(width), height(height), stride(stride / 4), antialias(antialias),
+    color(0xff000000), segments(0), stamps(0), markerSize(0), seen(NULL), seenWidth(0)
+{
+	last.x = last.y = 0;
+	setClip(0, 0, width, height);
+}
+
+void Rasterizer::setClip(double x, double y, double w, double h) {
+	clipX0 = (x > 0) ? (int) floor(x) : 0;
+	clipY0 = (y > 0) ? (int) floor(y) : 0;
+	clipX1 = (x + w < width) ? (int) ceil(x + w) - 1 : width - 1;
+	clipY1 = (y + h < height) ? (int) ceil(y + h) - 1 : height - 1;
+}
+
+void Rasterizer::setColor(double red, double green, double blue) {
+	color = 0xff000000 |
+		(uint32_t) (red * 255 + 0.5) << 16 |
+		(uint32_t) (green * 255 + 0.5) << 8 |
+		(uint32_t) (blue * 255 + 0.5);
+}
+
+void Rasterizer::moveTo(double x, double y) {
+	last.x = x;
+	last.y = y;
+}
+
+void Rasterizer::lineTo(double x, double y) {
+	double x0 = last.x, y0 = last.y, x1 = x, y1 = y;
+
+	last.x = x;
+	last.y = y;
+	segments++;
+
+	if (!clipLine(&x0, &y0, &x1, &y1))
+		return;
+
+	if (antialias)
+		lineWu(x0, y0, x1, y1);
+	else
+		line(x0, y0, x1, y1);
+}
+
+void Rasterizer::setMarker(double radius, std::vector<uint32_t> &bits) {
+	const int SUB = 8; /* subsamples per pixel and axis */
+
+	if (radius > MAX_MARKER / 2) radius = MAX_MARKER / 2;
+	if (radius < 0.5) radius = 0.5;
+
+	markerSize = 2 * (int) ceil(radius - 0.5) + 1;
+
+	/* coverage of the disc around the center of the middle pixel */
+	int c = markerSize / 2;
+	for (int j = 0; j < markerSize; j++) {
+		for (int i = 0; i < markerSize; i++) {
+			int inside = 0;
+
+			for (int sj = 0; sj < SUB; sj++) {
+				for (int si = 0; si < SUB; si++) {
+					double dx = i - c + (si + 0.5) / SUB - 0.5;
+					double dy = j - c + (sj + 0.5) / SUB - 0.5;
+					inside += (dx*dx + dy*dy <= radius*radius);
+				}
+			}
+
+			if (antialias)
+				marker[j * markerSize + i] = inside * 256 / (SUB * SUB);
+			else
+				marker[j * markerSize + i] = (inside * 2 >= SUB * SUB) ? 256 : 0;
+		}
+	}
+
+	/* centers of markers reaching into the clip rectangle */
+	seenWidth = clipX1 - clipX0 + 1 + 2 * c;
+	int seenHeight = clipY1 - clipY0 + 1 + 2 * c;
+
+	if (clipX1 < clipX0 || clipY1 < clipY0) {
+		seen = NULL;
+		return;
+	}
+
+	bits.assign(((size_t) seenWidth * seenHeight + 31) / 32, 0);
+	seen = &bits[0];
+}
+
+void Rasterizer::stamp(double x, double y) {
+	if (!seen) return;
+
+	int c = markerSize / 2;
+
+	/* also rejects NaN */
+	if (!(x >= clipX0 - c && x < clipX1 + 1 + c && y >= clipY0 - c && y < clipY1 + 1 + c))
+		return;
+
+	int ix = (int) floor(x), iy = (int) floor(y);
+	size_t bit = (size_t) (iy - clipY0 + c) * seenWidth + (ix - clipX0 + c);
+
+	if (seen[bit / 32] & (1u << (bit % 32)))
+		return; /* same pixel as an earlier point */
+
+	seen[bit / 32] |= 1u << (bit % 32);
+	stamps++;
+
+	/* sprite rectangle clipped once, no checks per pixel */
+	int i0 = (ix - c < clipX0) ? clipX0 - (ix - c) : 0;
+	int j0 = (iy - c < clipY0) ? clipY0 - (iy - c) : 0;
+	int i1 = (ix - c + markerSize - 1 > clipX1) ? clipX1 - (ix - c) + 1 : markerSize;
+	int j1 = (iy - c + markerSize - 1 > clipY1) ? clipY1 - (iy - c) + 1 : markerSize;
+
+	for (int j = j0; j < j1; j++) {
+		const unsigned short *m = marker + j * markerSize;
+		uint32_t *p = data + (iy - c + j) * stride + (ix - c);
+
+		for (int i = i0; i < i1; i++) {
+			if (m[i] == 256)
+				p[i] = color;
+			else if (m[i])
+				mix(p + i, m[i]);
+		}
+	}
+}
+
+/**
+ * Liang-Barsky against the clip rectangle, widened by a pixel for the
+ * neighbours Wu's algorithm blends into
+ */
+bool Rasterizer::clipLine(double *x0, double *y0, double *x1, double *y1) const {
+	if (clipX1 < clipX0 || clipY1 < clipY0)
+		return false;
+
+	double margin = antialias ? 1 : 0;
+	double xmin = clipX0 - margin, ymin = clipY0 - margin;
+	double xmax = clipX1 + 1 + margin, ymax = clipY1 + 1 + margin;
+
+	/* most segments of a plot are inside */
+	if (*x0 >= xmin && *x0 < xmax && *x1 >= xmin && *x1 < xmax &&
+	    *y0 >= ymin && *y0 < ymax && *y1 >= ymin && *y1 < ymax)
+		return true;
+
+	double dx = *x1 - *x0, dy = *y1 - *y0;
+	double p[4] = { -dx, dx, -dy, dy };
+	double q[4] = { *x0 - xmin, xmax - *x0, *y0 - ymin, ymax - *y0 };
+	double t0 = 0, t1 = 1;
+
+	for (int i = 0; i < 4; i++) {
+		if (!(q[i] == q[i]))
+			return false; /* NaN */
+
+		if (p[i] == 0) {
+			if (q[i] < 0) return false;
+		}
+		else {
+			double t = q[i] / p[i];
+
+			if (p[i] < 0) {
+				if (t > t1) return false;
+				if (t > t0) t0 = t;
+			}
+			else {
+				if (t < t0) return false;
+				if (t < t1) t1 = t;
+			}
+		}
+	}
+
+	if (t1 < 1) {
+		*x1 = *x0 + t1 * dx;
+		*y1 = *y0 + t1 * dy;
+	}
+
+	if (t0 > 0) {
+		*x0 += t0 * dx;
+		*y0 += t0 * dy;
+	}
+
+	return true;
+}
+
+static inline int clamp(int v, int min, int max) {
+	return (v < min) ? min : (v > max) ? max : v;
+}
+
+/**
+ * Bresenham, endpoints included
+ */
+void Rasterizer::line(double fx0, double fy0, double fx1, double fy1) {
+	/* rounding of the clipped endpoints may leave the rectangle */
+	int x0 = clamp((int) floor(fx0), clipX0, clipX1), y0 = clamp((int) floor(fy0), clipY0, clipY1);
+	int x1 = clamp((int) floor(fx1), clipX0, clipX1), y1 = clamp((int) floor(fy1), clipY0, clipY1);
+
+	int dx = abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+	int dy = -abs(y1 - y0), sy = (y0 < y1) ? stride : -stride;
+	int err = dx + dy;
+
+	uint32_t *p = data + y0 * stride + x0;
+	uint32_t *end = data + y1 * stride + x1;
+
+	for (;;) {
+		*p = color;
+		if (p == end) break;
+
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			p += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			p += sy;
+		}
+	}
+}
+
+static inline double fpart(double x) {
+	return x - floor(x);
+}
+
+/**
+ * Xiaolin Wu, in pixel centers
+ */
+void Rasterizer::lineWu(double x0, double y0, double x1, double y1) {
+	x0 -= 0.5; y0 -= 0.5;
+	x1 -= 0.5; y1 -= 0.5;
+
+	bool steep = fabs(y1 - y0) > fabs(x1 - x0);
+	double t;
+
+	if (steep) {
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+
+	if (x0 > x1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+
+	double dx = x1 - x0, dy = y1 - y0;
+	double gradient = (dx == 0) ? 1 : dy / dx;
+
+	/* endpoints, weighted by their horizontal coverage */
+	double xend = floor(x0 + 0.5);
+	double yend = y0 + gradient * (xend - x0);
+	double xgap = 1 - fpart(x0 + 0.5);
+	int xpx1 = (int) xend, ypx1 = (int) floor(yend);
+	double f = fpart(yend);
+
+	if (steep) {
+		blend(ypx1, xpx1, (int) ((1 - f) * xgap * 256));
+		blend(ypx1 + 1, xpx1, (int) (f * xgap * 256));
+	}
+	else {
+		blend(xpx1, ypx1, (int) ((1 - f) * xgap * 256));
+		blend(xpx1, ypx1 + 1, (int) (f * xgap * 256));
+	}
+
+	double intery = yend + gradient;
+
+	xend = floor(x1 + 0.5);
+	yend = y1 + gradient * (xend - x1);
+	xgap = fpart(x1 + 0.5);
+	int xpx2 = (int) xend, ypx2 = (int) floor(yend);
+	f = fpart(yend);
+
+	if (xpx2 != xpx1) {
+		if (steep) {
+			blend(ypx2, xpx2, (int) ((1 - f) * xgap * 256));
+			blend(ypx2 + 1, xpx2, (int) (f * xgap * 256));
+		}
+		else {
+			blend(xpx2, ypx2, (int) ((1 - f) * xgap * 256));
+			blend(xpx2, ypx2 + 1, (int) (f * xgap * 256));
+		}
+	}
+
+	/* span between the endpoints, y in 16.16 fixed point */
+	int32_t y = (int32_t) (intery * 65536), dy16 = (int32_t) (gradient * 65536);
+
+	if (steep) {
+		for (int x = xpx1 + 1; x < xpx2; x++, y += dy16) {
+			int a = (y >> 8) & 0xff;
+
+			blend(y >> 16, x, 256 - a);
+			blend((y >> 16) + 1, x, a);
+		}
+	}
+	else {
+		for (int x = xpx1 + 1; x < xpx2; x++, y += dy16) {
+			int a = (y >> 8) & 0xff;
+
+			blend(x, y >> 16, 256 - a);
+			blend(x, (y >> 16) + 1, a);
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef _RASTERIZER_H_
+#define _RASTERIZER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "Decimator.h"
+
+/**
+ * Draws 1 px polylines and markers directly into 32 bit pixels (FORMAT_RGB24 or ARGB32)
+ *
+ * Bypasses the path construction and stroking of cairo for thin solid
+ * lines: Bresenham for aliased lines, Xiaolin Wu for antialiased ones.
+ * Markers of scatter plots are stamped from a pre-rasterized sprite.
+ * Coordinates are the same as cairo's, pixel (i, j) covers [i, i+1) x [j, j+1).
+ * Nothing outside the clip rectangle is touched.
+ *
+ * The caller has to flush() the cairo surface before and mark_dirty() it
+ * afterwards.
+ */
+class Rasterizer {
+
+  public:
+	/**
+	 * @param stride	Bytes per row
+	 */
+	Rasterizer(unsigned char *data, int width, int height, int stride, bool antialias = false);
+
+	/**
+	 * Restrict drawing to a rectangle in pixels
+	 */
+	void setClip(double x, double y, double width, double height);
+	void setColor(double red, double green, double blue);
+
+	void moveTo(double x, double y);
+	void lineTo(double x, double y);
+
+	/**
+	 * Marker for stamp(): a disc centered on the pixel of the point
+	 *
+	 * Call after setClip(). The bitmap is scratch space with one bit per
+	 * pixel of the clip rectangle, so each position is stamped only once.
+	 *
+	 * @param radius	In pixels, up to MAX_MARKER / 2
+	 */
+	void setMarker(double radius, std::vector<uint32_t> &seen);
+	void stamp(double x, double y);
+
+	/* segments and markers drawn so far */
+	unsigned long long getSegments() const { return segments; }
+	unsigned long long getStamps() const { return stamps; }
+
+	static const int MAX_MARKER = 15; /* pixels */
+
+  protected:
+	uint32_t *data;
+	int width, height, stride; /* stride in pixels */
+	bool antialias;
+
+	/* clip rectangle in pixels, inclusive */
+	int clipX0, clipY0, clipX1, clipY1;
+
+	uint32_t color;
+	Point last;
+	unsigned long long segments, stamps;
+
+	/* coverage of the marker (0..256) and the positions stamped already */
+	unsigned short marker[MAX_MARKER * MAX_MARKER];
+	int markerSize;
+	uint32_t *seen;
+	int seenWidth;
+
+	bool clipLine(double *x0, double *y0, double *x1, double *y1) const;
+
+	void line(double x0, double y0, double x1, double y1);
+	void lineWu(double x0, double y0, double x1, double y1);
+
+	/**
+	 * Blend color with coverage alpha (0..256) over the pixel
+	 */
+	void blend(int x, int y, int alpha) {
+		if (alpha <= 0 || x < clipX0 || x > clipX1 || y < clipY0 || y > clipY1) return;
+
+		mix(data + y * stride + x, alpha);
+	}
+
+	void mix(uint32_t *p, int alpha) {
+		uint32_t d = *p;
+
+		/* red and blue at once, the borrow does not reach the other channel */
+		uint32_t rb = (((((color & 0xff00ff) - (d & 0xff00ff)) * alpha) >> 8) + d) & 0xff00ff;
+		uint32_t g = (((((color & 0x00ff00) - (d & 0x00ff00)) * alpha) >> 8) + d) & 0x00ff00;
+
+		*p = 0xff000000 | rb | g;
+	}
+};
+
+#endif /* _RASTERIZER_H_ */
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Recorder.h"
+#include "Clock.h"
+
+const char Recorder::MAGIC[8] = { 'C', 'A', 'R', 'R', 'E', 'C', '\0', '\0' };
+
+Recorder::Recorder(const char *path, size_t capacity, const char * const *names, unsigned channels) {
+	const size_t maxChannels = sizeof(header->names) / sizeof(header->names[0]);
+	struct stat st;
+	bool resume;
+
+	if (channels > maxChannels) {
+		fprintf(stderr, "Too many channels for the recorder: %u\n", channels);
+		exit(EXIT_FAILURE);
+	}
+
+	for (unsigned i = 0; i < channels; i++) {
+		if (strlen(names[i]) >= sizeof(header->names[i])) {
+			fprintf(stderr, "Channel name too long for the recorder: %s\n", names[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	size = HEADER_SIZE + capacity * sizeof(RecorderRecord);
+	resume = (size_t) st.st_size == size;
+
+	/* allocate all blocks now: no SIGBUS on a full disk while recording */
+	if (!resume && (ftruncate(fd, 0) || posix_fallocate(fd, 0, size))) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		exit(EXIT_FAILURE);
+	}
+
+	close(fd); /* the mapping keeps the file */
+
+	header = (RecorderHeader *) map;
+	records = (RecorderRecord *) ((char *) map + HEADER_SIZE);
+
+	/* continue a recording with the same layout and schema */
+	resume = resume && !memcmp(header->magic, MAGIC, sizeof(MAGIC)) &&
+		header->version == VERSION && header->recordSize == sizeof(RecorderRecord) &&
+		header->capacity == capacity && header->channels == channels;
+
+	for (unsigned i = 0; resume && i < channels; i++)
+		resume = !strncmp(header->names[i], names[i], sizeof(header->names[i]));
+
+	if (!resume) {
+		memset(header, 0, HEADER_SIZE);
+		memcpy(header->magic, MAGIC, sizeof(MAGIC));
+		header->version = VERSION;
+		header->recordSize = sizeof(RecorderRecord);
+		header->capacity = capacity;
+		header->channels = channels;
+
+		for (unsigned i = 0; i < channels; i++)
+			strncpy(header->names[i], names[i], sizeof(header->names[i]) - 1);
+	}
+
+	this->capacity = capacity;
+	cursor = header->cursor;
+	pos = cursor % capacity;
+}
+
+Recorder::~Recorder() {
+	sync();
+	munmap(header, size);
+}
+
+void Recorder::sync() {
+	msync(header, size, MS_ASYNC);
+}
+
+ReplayAcquisition::ReplayAcquisition(const char *path, double speed)
+  : speed(speed), replayed(0)
+{
+	struct stat st;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	size = st.st_size;
+	if (size < Recorder::HEADER_SIZE) {
+		fprintf(stderr, "%s: not a recording\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		exit(EXIT_FAILURE);
+	}
+
+	close(fd);
+
+	header = (const RecorderHeader *) map;
+	records = (const RecorderRecord *) ((const char *) map + Recorder::HEADER_SIZE);
+
+	if (memcmp(header->magic, Recorder::MAGIC, sizeof(Recorder::MAGIC)) ||
+	    header->version != Recorder::VERSION || header->recordSize != sizeof(RecorderRecord) ||
+	    header->capacity == 0 || size < Recorder::HEADER_SIZE + header->capacity * sizeof(RecorderRecord)) {
+		fprintf(stderr, "%s: not a recording or unsupported version\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	/* the ring holds the last capacity records before the cursor */
+	last = __atomic_load_n(&header->cursor, __ATOMIC_ACQUIRE);
+	first = (last > header->capacity) ? last - header->capacity : 0;
+}
+
+ReplayAcquisition::~ReplayAcquisition() {
+	stop();
+	munmap((void *) header, size);
+}
+
+bool ReplayAcquisition::setSeries(const char *name, PlotSeries *series) {
+	for (unsigned i = 0; i < header->channels; i++) {
+		if (!strncmp(header->names[i], name, sizeof(header->names[i]))) {
+			setChannel(i, series);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ReplayAcquisition::run() {
+	double start = Clock::now(), origin = 0;
+	bool started = false;
+
+	for (uint64_t c = first; c < last && running; c++) {
+		const RecorderRecord *r = &records[c % header->capacity];
+
+		if (r->seq != (uint32_t) c)
+			continue; /* slot overwritten or torn by a crash */
+
+		if (!started) {
+			origin = r->time;
+			started = true;
+		}
+
+		if (speed > 0) {
+			double delay;
+
+			/* short sleeps to notice stop() during gaps in the recording */
+			while (running && (delay = start + (r->time - origin) / speed - Clock::now()) > 1e-3) {
+				flush();
+				usleep((delay < 0.1 ? delay : 0.1) * 1e6);
+			}
+		}
+		else if (!reserve()) {
+			break;
+		}
+
+		push(r->channel, r->value, r->time);
+		replayed++;
+	}
+
+	flush();
+}
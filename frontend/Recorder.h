@@ -0,0 +1,134 @@
+#ifndef _RECORDER_H_
+#define _RECORDER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Acquisition.h"
+
+/**
+ * On-disk layout of a recording
+ *
+ * A page with the header is followed by a ring of fixed-size records. The
+ * file is mapped shared, so everything written survives a crash of the
+ * frontend. cursor is published after the record is complete: records
+ * at or beyond cursor are ignored on replay.
+ */
+struct RecorderHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t capacity;	/* records in the ring */
+	uint64_t cursor;	/* records written in total, next one goes to cursor % capacity */
+	uint32_t channels;
+	uint32_t reserved;
+	char names[32][32];	/* schema: channel names, NUL-terminated */
+};
+
+struct RecorderRecord {
+	double time;
+	double value;
+	uint32_t seq;		/* lower bits of its position in the stream, validates the slot */
+	uint32_t channel;
+};
+
+/**
+ * Flight recorder for all samples of an Acquisition
+ *
+ * Appends to a memory-mapped ring file without any syscall per sample.
+ * Reopening an existing recording with the same layout continues it.
+ */
+class Recorder {
+
+  public:
+	/**
+	 * @param capacity	Number of records in the ring
+	 * @param names		Schema: names of the channels
+	 */
+	Recorder(const char *path, size_t capacity, const char * const *names, unsigned channels);
+	~Recorder();
+
+	/**
+	 * Record a sample (acquisition thread only)
+	 */
+	void append(const Sample &s) {
+		RecorderRecord *r = &records[pos];
+
+		/* invalidate the slot first (a position of the next slot), a crash
+		 * while writing the payload must not leave a torn record */
+		__atomic_store_n(&r->seq, (uint32_t) (cursor - capacity + 1), __ATOMIC_RELAXED);
+		__atomic_signal_fence(__ATOMIC_RELEASE);
+
+		r->time = s.time;
+		r->value = s.value;
+		r->channel = s.channel;
+
+		__atomic_store_n(&r->seq, (uint32_t) cursor, __ATOMIC_RELEASE);
+
+		if (++pos == capacity) pos = 0;
+
+		__atomic_store_n(&header->cursor, ++cursor, __ATOMIC_RELEASE);
+	}
+
+	/**
+	 * Schedule write back to the disk (no-op for crash safety of the process)
+	 */
+	void sync();
+
+	unsigned long long getCursor() const { return cursor; }
+
+	static const char MAGIC[8];
+	static const uint32_t VERSION = 2;
+	static const size_t HEADER_SIZE = 4096;
+
+  protected:
+	RecorderHeader *header;
+	RecorderRecord *records;
+	size_t size;
+
+	/* private copies, avoid a division per sample */
+	uint64_t cursor;
+	size_t capacity, pos;
+
+  private:
+	/* not copyable */
+	Recorder(const Recorder &);
+	Recorder & operator=(const Recorder &);
+};
+
+/**
+ * Plays a recording back into the plots
+ */
+class ReplayAcquisition : public Acquisition {
+
+  public:
+	/**
+	 * @param speed		1 for realtime, 0 for as fast as possible
+	 */
+	ReplayAcquisition(const char *path, double speed = 1);
+	virtual ~ReplayAcquisition();
+
+	/**
+	 * Route a channel by its name in the schema of the recording
+	 *
+	 * @return false if the recording has no such channel
+	 */
+	bool setSeries(const char *name, PlotSeries *series);
+
+	/* number of valid records */
+	unsigned long long getRecords() const { return last - first; }
+	unsigned long long getReplayed() const { return replayed; }
+
+  protected:
+	const RecorderHeader *header;
+	const RecorderRecord *records;
+	size_t size;
+
+	double speed;
+	uint64_t first, last;
+	volatile unsigned long long replayed;
+
+	void run();
+};
+
+#endif /* _RECORDER_H_ */
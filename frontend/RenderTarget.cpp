@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RenderTarget.h"
+
+using namespace Cairo;
+
+WindowTarget::WindowTarget(const char *title, int width, int height, bool shared)
+  : shm(NULL), shared(shared)
+{
+	this->width = width;
+	this->height = height;
+
+	window = XWindow::create(title, 1, 1, width, height);
+	surface = XlibSurface::create(window->getDisplay(), window->getWindow(), window->getVisual(), width, height);
+	createBuffer();
+}
+
+WindowTarget::~WindowTarget() {
+	buffer.clear();
+	delete shm;
+}
+
+void WindowTarget::createBuffer() {
+	ShmImage *old = shm;
+
+	shm = shared ? ShmImage::create(window, width, height) : NULL;
+	buffer = shm ? shm->getSurface() : ImageSurface::create(FORMAT_RGB24, width, height);
+
+	delete old; /* no longer referenced by buffer */
+}
+
+void WindowTarget::resize(int w, int h) {
+	width = w;
+	height = h;
+
+	surface->set_size(width, height);
+	createBuffer();
+}
+
+void WindowTarget::present(int x, int y, int w, int h) {
+	if (shm) {
+		shm->put(x, y, w, h);
+	}
+	else {
+		RefPtr<Context> ctx = Context::create(surface);
+		ctx->set_operator(OPERATOR_SOURCE);
+		ctx->set_source(buffer, 0, 0);
+		ctx->rectangle(x, y, w, h);
+		ctx->fill();
+
+		surface->flush();
+		XFlush(window->getDisplay());
+	}
+}
+
+ImageTarget::ImageTarget(int width, int height)
+  : frames(0)
+{
+	resize(width, height);
+}
+
+void ImageTarget::resize(int w, int h) {
+	width = w;
+	height = h;
+	buffer = ImageSurface::create(FORMAT_RGB24, width, height);
+}
+
+FrameSink::FrameSink(const char *path, enum Format format, int width, int height)
+  : ImageTarget(width, height), path(path), format(format), raw(NULL)
+{
+	if (format == FORMAT_RAW) {
+		raw = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+		if (!raw) {
+			perror(path);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+FrameSink::~FrameSink() {
+	if (raw && raw != stdout)
+		fclose(raw);
+	else if (raw)
+		fflush(raw);
+}
+
+void FrameSink::present(int x, int y, int w, int h) {
+	/* always the whole frame, a file does not keep the previous one */
+	if (format == FORMAT_PNG) {
+		char name[1024];
+
+		snprintf(name, sizeof(name), "%s%05lu.png", path.c_str(), frames);
+		buffer->write_to_png(name);
+	}
+	else {
+		const unsigned char *data = buffer->get_data();
+		int stride = buffer->get_stride();
+
+		row.resize(4 * width);
+
+		/* native 32 bit xRGB to R, G, B, A bytes */
+		for (int j = 0; j < height; j++) {
+			const uint32_t *p = (const uint32_t *) (data + j * stride);
+
+			for (int i = 0; i < width; i++) {
+				row[4*i + 0] = p[i] >> 16;
+				row[4*i + 1] = p[i] >> 8;
+				row[4*i + 2] = p[i];
+				row[4*i + 3] = 0xff;
+			}
+
+			if (fwrite(&row[0], 4, width, raw) != (size_t) width) {
+				perror("fwrite");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	frames++;
+}
@@ -0,0 +1,124 @@
+#ifndef _RENDERTARGET_H_
+#define _RENDERTARGET_H_
+
+#include <stdio.h>
+
+#include <vector>
+#include <string>
+#include <cairomm/cairomm.h>
+#include <cairomm/xlib_surface.h>
+
+#include "XWindow.h"
+#include "ShmImage.h"
+
+/**
+ * Destination of the frames rendered by a Plot
+ *
+ * A Plot renders each frame into the client-side back buffer of its
+ * target (FORMAT_RGB24) and calls present() afterwards.
+ */
+class RenderTarget {
+
+  public:
+	virtual ~RenderTarget() { }
+
+	/**
+	 * Change the size of the back buffer (invalidates getBuffer())
+	 */
+	virtual void resize(int width, int height) = 0;
+
+	/**
+	 * Make a rectangle of the back buffer visible
+	 */
+	virtual void present(int x, int y, int width, int height) = 0;
+
+	/**
+	 * Window receiving the input events, empty for headless targets
+	 */
+	virtual Cairo::RefPtr<XWindow> getWindow() const { return Cairo::RefPtr<XWindow>(); }
+
+	Cairo::RefPtr<Cairo::ImageSurface> getBuffer() const { return buffer; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+  protected:
+	Cairo::RefPtr<Cairo::ImageSurface> buffer;
+	int width, height;
+};
+
+/**
+ * X11 window, presented by MIT-SHM or through the socket
+ */
+class WindowTarget : public RenderTarget {
+
+  public:
+	/**
+	 * @param shared	Render into memory shared with the X server if possible
+	 */
+	WindowTarget(const char *title, int width, int height, bool shared = true);
+	virtual ~WindowTarget();
+
+	void resize(int width, int height);
+	void present(int x, int y, int width, int height);
+
+	Cairo::RefPtr<XWindow> getWindow() const { return window; }
+
+	/* presented by MIT-SHM */
+	bool isShared() const { return shm != NULL; }
+
+  protected:
+	Cairo::RefPtr<XWindow> window;
+	Cairo::RefPtr<Cairo::XlibSurface> surface;
+	ShmImage *shm; /* owner of buffer if shared */
+	bool shared;
+
+	void createBuffer();
+};
+
+/**
+ * Offscreen image, for batch rendering and measurements without X
+ */
+class ImageTarget : public RenderTarget {
+
+  public:
+	ImageTarget(int width, int height);
+
+	void resize(int width, int height);
+	void present(int x, int y, int width, int height) { frames++; }
+
+	unsigned long getFrames() const { return frames; }
+
+  protected:
+	unsigned long frames;
+};
+
+/**
+ * Offscreen image which writes every presented frame to files
+ */
+class FrameSink : public ImageTarget {
+
+  public:
+	enum Format {
+		FORMAT_PNG,	/* one file per frame */
+		FORMAT_RAW	/* all frames appended as 8 bit RGBA */
+	};
+
+	/**
+	 * @param path	For PNG the prefix of the files, "frame-" gives
+	 *		"frame-00000.png"..., for raw frames a file or "-" for stdout
+	 */
+	FrameSink(const char *path, enum Format format, int width, int height);
+	virtual ~FrameSink();
+
+	void present(int x, int y, int width, int height);
+
+  protected:
+	std::string path;
+	enum Format format;
+
+	FILE *raw;
+	std::vector<unsigned char> row;
+};
+
+#endif /* _RENDERTARGET_H_ */
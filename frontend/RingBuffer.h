@@ -0,0 +1,132 @@
+#ifndef _RINGBUFFER_H_
+#define _RINGBUFFER_H_
+
+#include <stddef.h>
+
+/**
+ * Fixed-capacity circular buffer
+ *
+ * The storage is allocated once in the constructor. Pushing to a full
+ * buffer evicts the oldest element, so there is no allocation in steady
+ * state. The elements are kept in at most two contiguous spans which can
+ * be obtained by spans() for fast sequential scans.
+ */
+template <typename T>
+class RingBuffer {
+
+  public:
+	class const_iterator {
+
+	  public:
+		const_iterator(const RingBuffer<T> *buf, size_t pos)
+		  : buf(buf), pos(pos) { }
+
+		const T & operator*() const { return (*buf)[pos]; }
+		const T * operator->() const { return &(*buf)[pos]; }
+
+		const_iterator & operator++() { pos++; return *this; }
+		const_iterator operator++(int) { const_iterator tmp = *this; pos++; return tmp; }
+
+		bool operator==(const const_iterator &other) const { return pos == other.pos; }
+		bool operator!=(const const_iterator &other) const { return pos != other.pos; }
+
+	  protected:
+		const RingBuffer<T> *buf;
+		size_t pos;
+	};
+
+	RingBuffer(size_t capacity)
+	  : cap(capacity ? capacity : 1), head(0), count(0)
+	{
+		data = new T[cap];
+	}
+
+	~RingBuffer() {
+		delete[] data;
+	}
+
+	/**
+	 * Append an element, evicting the oldest one if the buffer is full
+	 */
+	void push_back(const T &value) {
+		if (count == cap) {
+			data[head] = value;
+			head = wrap(head + 1);
+		}
+		else {
+			data[wrap(head + count)] = value;
+			count++;
+		}
+	}
+
+	void pop_front() {
+		if (count) {
+			head = wrap(head + 1);
+			count--;
+		}
+	}
+
+	void pop_back() {
+		if (count) count--;
+	}
+
+	void clear() {
+		head = count = 0;
+	}
+
+	T & operator[](size_t i) { return data[wrap(head + i)]; }
+	const T & operator[](size_t i) const { return data[wrap(head + i)]; }
+
+	T & front() { return data[head]; }
+	const T & front() const { return data[head]; }
+	T & back() { return data[wrap(head + count - 1)]; }
+	const T & back() const { return data[wrap(head + count - 1)]; }
+
+	size_t size() const { return count; }
+	size_t capacity() const { return cap; }
+	bool empty() const { return count == 0; }
+	bool full() const { return count == cap; }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, count); }
+
+	/**
+	 * Get the contents as two contiguous spans in logical order
+	 *
+	 * @param first		Oldest elements, up to the end of the storage
+	 * @param firstLen	Number of elements in first
+	 * @param second	Remaining elements from the start of the storage
+	 * @param secondLen	Number of elements in second (may be 0)
+	 * @return		Total number of elements
+	 */
+	size_t spans(const T **first, size_t *firstLen, const T **second, size_t *secondLen) const {
+		size_t tail = cap - head;
+
+		*first = data + head;
+		*second = data;
+
+		if (count <= tail) {
+			*firstLen = count;
+			*secondLen = 0;
+		}
+		else {
+			*firstLen = tail;
+			*secondLen = count - tail;
+		}
+
+		return count;
+	}
+
+  protected:
+	T *data;
+	size_t cap, head, count;
+
+	size_t wrap(size_t i) const { return (i >= cap) ? i - cap : i; }
+
+  private:
+	/* not copyable */
+	RingBuffer(const RingBuffer &);
+	RingBuffer & operator=(const RingBuffer &);
+};
+
+#endif /* _RINGBUFFER_H_ */
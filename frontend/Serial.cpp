@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "Serial.h"
+#include "Clock.h"
+
+static speed_t baudrate2speed(int baudrate) {
+	switch (baudrate) {
+		case 9600:	return B9600;
+		case 19200:	return B19200;
+		case 38400:	return B38400;
+		case 57600:	return B57600;
+		case 115200:	return B115200;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		case 500000:	return B500000;
+		case 921600:	return B921600;
+		case 1000000:	return B1000000;
+		case 2000000:	return B2000000;
+		default:	return B0;
+	}
+}
+
+SerialPort::SerialPort(const char *port, int baudrate) {
+	struct termios tio;
+	speed_t speed = baudrate2speed(baudrate);
+
+	if (speed == B0) {
+		fprintf(stderr, "Unsupported baudrate: %d\n", baudrate);
+		exit(EXIT_FAILURE);
+	}
+
+	fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		perror(port);
+		exit(EXIT_FAILURE);
+	}
+
+	if (tcgetattr(fd, &tio)) {
+		perror("tcgetattr");
+		exit(EXIT_FAILURE);
+	}
+
+	/* 8N1, no flow control, no line processing */
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+
+	if (tcsetattr(fd, TCSANOW, &tio)) {
+		perror("tcsetattr");
+		exit(EXIT_FAILURE);
+	}
+
+	tcflush(fd, TCIFLUSH);
+}
+
+SerialPort::~SerialPort() {
+	close(fd);
+}
+
+ssize_t SerialPort::read(char *buf, size_t len) {
+	ssize_t ret = ::read(fd, buf, len);
+
+	if (ret < 0 && (errno == EAGAIN || errno == EINTR))
+		return 0;
+
+	return ret;
+}
+
+SerialAcquisition::SerialAcquisition(const char *name, int baudrate, TelemetryParser *parser)
+  : port(name, baudrate), parser(parser), bytes(0), samples(0)
+{ }
+
+SerialAcquisition::~SerialAcquisition() {
+	stop();
+	delete parser;
+}
+
+bool SerialAcquisition::setSeries(const char *name, PlotSeries *series) {
+	int ch = TelemetryParser::lookup(name);
+	if (ch < 0) return false;
+
+	setChannel(ch, series);
+	return true;
+}
+
+void SerialAcquisition::sample(unsigned channel, double value, double time) {
+	push(channel, value, time);
+	samples++;
+}
+
+void SerialAcquisition::run() {
+	char *buf = new char[CHUNK];
+	struct pollfd pfd = { port.getFd(), POLLIN, 0 };
+
+	while (running) {
+		/* timeout to check for stop() */
+		if (poll(&pfd, 1, 100) <= 0) continue;
+
+		/* drain everything the driver has buffered in large reads */
+		ssize_t len;
+		while ((len = port.read(buf, CHUNK)) > 0) {
+			parser->feed(buf, len, Clock::now(), this);
+			bytes += len;
+		}
+
+		if (len < 0) {
+			perror("read");
+			break;
+		}
+
+		flush();
+	}
+
+	delete[] buf;
+}
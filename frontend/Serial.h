@@ -0,0 +1,66 @@
+#ifndef _SERIAL_H_
+#define _SERIAL_H_
+
+#include "Acquisition.h"
+#include "Telemetry.h"
+
+/**
+ * Non-blocking serial port in raw mode
+ */
+class SerialPort {
+
+  public:
+	SerialPort(const char *port, int baudrate = 57600);
+	virtual ~SerialPort();
+
+	/**
+	 * Read whatever is available
+	 *
+	 * @return number of bytes, 0 if nothing is available, -1 on error
+	 */
+	ssize_t read(char *buf, size_t len);
+
+	int getFd() const { return fd; }
+
+  protected:
+	int fd;
+};
+
+/**
+ * Reads telemetry from the car's UART in the acquisition thread
+ */
+class SerialAcquisition : public Acquisition, public TelemetrySink {
+
+  public:
+	/**
+	 * @param parser	Decoder for the stream, owned by this object
+	 */
+	SerialAcquisition(const char *port, int baudrate, TelemetryParser *parser);
+	virtual ~SerialAcquisition();
+
+	/**
+	 * Route a telemetry channel by its name (see TelemetryParser::lookup())
+	 *
+	 * @return false if the name is unknown
+	 */
+	bool setSeries(const char *name, PlotSeries *series);
+
+	/* statistics, may be read from any thread */
+	unsigned long long getBytes() const { return bytes; }
+	unsigned long long getSamples() const { return samples; }
+	unsigned long long getErrors() const { return parser->getErrors(); }
+
+	void sample(unsigned channel, double value, double time);
+
+  protected:
+	SerialPort port;
+	TelemetryParser *parser;
+
+	volatile unsigned long long bytes, samples;
+
+	void run();
+
+	static const size_t CHUNK = 1 << 16; /* maximum bytes per read */
+};
+
+#endif /* _SERIAL_H_ */
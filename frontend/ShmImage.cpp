@@ -0,0 +1,97 @@
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "ShmImage.h"
+
+using namespace Cairo;
+
+bool ShmImage::failed = false;
+
+int ShmImage::handleError(Display *display, XErrorEvent *e) {
+	failed = true;
+
+	return 0;
+}
+
+ShmImage * ShmImage::create(RefPtr<XWindow> window, int width, int height) {
+	Display *display = XWindow::getDisplay();
+	Visual *visual = window->getVisual();
+	int depth = DefaultDepth(display, DefaultScreen(display));
+	XShmSegmentInfo info;
+
+	if (!XShmQueryExtension(display))
+		return NULL;
+
+	/* cairo's FORMAT_RGB24 is 32 bit xRGB in native byte order */
+	if (depth != 24 || visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 || visual->blue_mask != 0xff)
+		return NULL;
+
+	XImage *image = XShmCreateImage(display, visual, depth, ZPixmap, NULL, &info, width, height);
+	if (!image)
+		return NULL;
+
+	if (image->bits_per_pixel != 32 || image->byte_order != ImageByteOrder(display) ||
+	    image->bytes_per_line != ImageSurface::format_stride_for_width(FORMAT_RGB24, width)) {
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	info.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * height, IPC_CREAT | 0600);
+	if (info.shmid < 0) {
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	info.shmaddr = image->data = (char *) shmat(info.shmid, NULL, 0);
+	info.readOnly = False;
+
+	/* removed as soon as both sides detached */
+	shmctl(info.shmid, IPC_RMID, NULL);
+
+	if (info.shmaddr == (char *) -1) {
+		image->data = NULL;
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	/* attaching fails asynchronously for remote displays */
+	failed = false;
+	XErrorHandler old = XSetErrorHandler(handleError);
+	XShmAttach(display, &info);
+	XSync(display, False);
+	XSetErrorHandler(old);
+
+	if (failed) {
+		shmdt(info.shmaddr);
+		image->data = NULL;
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	return new ShmImage(window, image, info);
+}
+
+ShmImage::ShmImage(RefPtr<XWindow> win, XImage *image, const XShmSegmentInfo &info)
+  : display(XWindow::getDisplay()), window(win->getWindow()), image(image), info(info)
+{
+	gc = XCreateGC(display, window, 0, NULL);
+	surface = ImageSurface::create((unsigned char *) image->data, FORMAT_RGB24,
+		image->width, image->height, image->bytes_per_line);
+}
+
+ShmImage::~ShmImage() {
+	surface->finish();
+
+	XShmDetach(display, &info);
+	XSync(display, False);
+	XFreeGC(display, gc);
+
+	shmdt(info.shmaddr);
+	image->data = NULL; /* not allocated by Xlib */
+	XDestroyImage(image);
+}
+
+void ShmImage::put(int x, int y, int width, int height) {
+	XShmPutImage(display, window, gc, image, x, y, x, y, width, height, False);
+	XSync(display, False);
+}
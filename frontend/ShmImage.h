@@ -0,0 +1,57 @@
+#ifndef _SHMIMAGE_H_
+#define _SHMIMAGE_H_
+
+#include <cairomm/cairomm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include "XWindow.h"
+
+/**
+ * Back buffer in memory shared with the X server (MIT-SHM)
+ *
+ * cairo renders directly into the segment and put() copies it to the
+ * window without sending the pixels through the socket.
+ */
+class ShmImage {
+
+  public:
+	/**
+	 * @return NULL if shared memory is not available (remote display,
+	 *         no extension, or a visual not matching FORMAT_RGB24)
+	 */
+	static ShmImage * create(Cairo::RefPtr<XWindow> window, int width, int height);
+	~ShmImage();
+
+	Cairo::RefPtr<Cairo::ImageSurface> getSurface() const { return surface; }
+
+	/**
+	 * Copy a rectangle to the same position in the window
+	 *
+	 * Waits until the server has read the segment, so it can be drawn
+	 * into again afterwards.
+	 */
+	void put(int x, int y, int width, int height);
+
+  protected:
+	ShmImage(Cairo::RefPtr<XWindow> window, XImage *image, const XShmSegmentInfo &info);
+
+	Display *display;
+	Window window;
+	GC gc;
+
+	XImage *image;
+	XShmSegmentInfo info;
+	Cairo::RefPtr<Cairo::ImageSurface> surface;
+
+	static bool failed;
+	static int handleError(Display *display, XErrorEvent *e);
+
+  private:
+	/* not copyable */
+	ShmImage(const ShmImage &);
+	ShmImage & operator=(const ShmImage &);
+};
+
+#endif /* _SHMIMAGE_H_ */
@@ -0,0 +1,68 @@
+#ifndef _SLIDINGEXTREMA_H_
+#define _SLIDINGEXTREMA_H_
+
+#include "RingBuffer.h"
+
+/**
+ * Minimum and maximum of a sliding window
+ *
+ * Mirrors the window of a FIFO by push() and evict() and keeps two
+ * monotonic queues of candidate extrema. Both operations are amortized
+ * O(1), min() and max() are O(1).
+ */
+class SlidingExtrema {
+
+  public:
+	SlidingExtrema(size_t window)
+	  : pushed(0), evicted(0), minima(window), maxima(window)
+	{ }
+
+	/**
+	 * A new value entered the window
+	 */
+	void push(double value) {
+		Entry e = { pushed++, value };
+
+		while (!maxima.empty() && maxima.back().value <= value) maxima.pop_back();
+		while (!minima.empty() && minima.back().value >= value) minima.pop_back();
+
+		maxima.push_back(e);
+		minima.push_back(e);
+	}
+
+	/**
+	 * The oldest value left the window
+	 */
+	void evict() {
+		if (evicted == pushed) return;
+
+		if (maxima.front().seq == evicted) maxima.pop_front();
+		if (minima.front().seq == evicted) minima.pop_front();
+
+		evicted++;
+	}
+
+	void clear() {
+		evicted = pushed;
+		minima.clear();
+		maxima.clear();
+	}
+
+	double min() const { return minima.front().value; }
+	double max() const { return maxima.front().value; }
+
+	bool empty() const { return evicted == pushed; }
+
+  protected:
+	struct Entry {
+		unsigned long long seq;
+		double value;
+	};
+
+	unsigned long long pushed, evicted;
+
+	RingBuffer<Entry> minima; /* ascending values, oldest first */
+	RingBuffer<Entry> maxima; /* descending values, oldest first */
+};
+
+#endif /* _SLIDINGEXTREMA_H_ */
@@ -0,0 +1,125 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include <stddef.h>
+
+/**
+ * Wait-free single-producer/single-consumer queue
+ *
+ * push() must only be called by one thread and pop() by one other
+ * thread. A full queue drops new items instead of blocking the producer.
+ */
+template <typename T>
+class SpscQueue {
+
+  public:
+	/**
+	 * @param capacity	Rounded up to the next power of two
+	 */
+	SpscQueue(size_t capacity)
+	  : head(0), tail(0), cachedTail(0), cachedHead(0), dropped(0), highWater(0)
+	{
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+
+		mask = size - 1;
+		buffer = new T[size];
+	}
+
+	~SpscQueue() {
+		delete[] buffer;
+	}
+
+	/**
+	 * Producer: append an item
+	 *
+	 * @return false if the queue was full and the item got dropped
+	 */
+	bool push(const T &item) {
+		size_t t = tail; /* only written by us */
+		size_t used = t - cachedHead;
+
+		if (used > mask) {
+			cachedHead = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+			used = t - cachedHead;
+
+			if (used > mask) {
+				__atomic_store_n(&dropped, dropped + 1, __ATOMIC_RELAXED);
+				return false;
+			}
+		}
+
+		buffer[t & mask] = item;
+		__atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+
+		return true;
+	}
+
+	/**
+	 * Producer: check for space without counting a drop
+	 */
+	bool full() {
+		size_t t = tail;
+
+		if (t - cachedHead > mask)
+			cachedHead = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+		return t - cachedHead > mask;
+	}
+
+	/**
+	 * Consumer: remove up to max items
+	 *
+	 * @return number of items copied to items
+	 */
+	size_t pop(T *items, size_t max) {
+		size_t h = head; /* only written by us */
+
+		if (cachedTail - h < max) {
+			cachedTail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+
+			/* cachedHead of the producer may be stale, only a fresh tail gives the fill level */
+			if (cachedTail - h > highWater)
+				__atomic_store_n(&highWater, cachedTail - h, __ATOMIC_RELAXED);
+
+			if (h == cachedTail) return 0;
+		}
+
+		size_t n = cachedTail - h;
+		if (n > max) n = max;
+
+		for (size_t i = 0; i < n; i++) {
+			items[i] = buffer[(h + i) & mask];
+		}
+
+		__atomic_store_n(&head, h + n, __ATOMIC_RELEASE);
+
+		return n;
+	}
+
+	size_t capacity() const { return mask + 1; }
+
+	/* statistics for sizing the queue, may be read from any thread */
+	unsigned long long getDrops() const { return __atomic_load_n(&dropped, __ATOMIC_RELAXED); }
+	size_t getHighWater() const { return __atomic_load_n(&highWater, __ATOMIC_RELAXED); }
+
+  protected:
+	T *buffer;
+	size_t mask;
+
+	/* separate cache lines for consumer and producer state */
+	size_t head __attribute__((aligned(64)));	/* written by consumer */
+	size_t tail __attribute__((aligned(64)));	/* written by producer */
+	size_t cachedTail __attribute__((aligned(64)));	/* consumer's copy of tail */
+	size_t cachedHead __attribute__((aligned(64)));	/* producer's copy of head */
+
+	unsigned long long dropped;
+	size_t highWater;	/* written by consumer */
+
+  private:
+	/* not copyable */
+	SpscQueue(const SpscQueue &);
+	SpscQueue & operator=(const SpscQueue &);
+};
+
+#endif /* _SPSCQUEUE_H_ */
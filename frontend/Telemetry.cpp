@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Telemetry.h"
+
+static const struct {
+	const char *name;
+	const char *key; /* short form used by the firmware */
+} channels[CHANNELS] = {
+	{ "speed",		"spd" },
+	{ "adc_stering_left",	"adc_l" },
+	{ "adc_stering_right",	"adc_r" },
+	{ "adc_batt_logic",	"batt_l" },
+	{ "adc_batt_drive",	"batt_d" },
+	{ "out_stering",	"stering" },
+	{ "out_drive",		"drive" }
+};
+
+int TelemetryParser::lookup(const char *name, size_t len) {
+	for (int i = 0; i < CHANNELS; i++) {
+		if (strlen(channels[i].key) == len && !strncmp(channels[i].key, name, len))
+			return i;
+		if (strlen(channels[i].name) == len && !strncmp(channels[i].name, name, len))
+			return i;
+	}
+
+	return -1;
+}
+
+int TelemetryParser::lookup(const char *name) {
+	return lookup(name, strlen(name));
+}
+
+const char * TelemetryParser::getName(unsigned channel) {
+	return (channel < CHANNELS) ? channels[channel].name : NULL;
+}
+
+void TextParser::feed(const char *data, size_t len, double time, TelemetrySink *sink) {
+	for (size_t i = 0; i < len; i++) {
+		char c = data[i];
+
+		if (c == '\r' || c == '\n') {
+			if (overflow)
+				errors++;
+			else if (length)
+				parseLine(time, sink);
+
+			length = 0;
+			overflow = false;
+		}
+		else if (length < sizeof(line) - 1) {
+			line[length++] = c;
+		}
+		else {
+			overflow = true;
+		}
+	}
+}
+
+void TextParser::parseLine(double time, TelemetrySink *sink) {
+	char *p = line, *end = line + length;
+	*end = '\0';
+
+	while (p < end) {
+		/* key */
+		while (p < end && (*p == ' ' || *p == ',')) p++;
+		char *key = p;
+		while (p < end && *p != '=' && *p != ',') p++;
+
+		if (p == end || *p != '=') {
+			if (key != p) errors++; /* key without value */
+			continue;
+		}
+
+		int ch = lookup(key, p - key);
+		p++;
+
+		/* value */
+		char *num;
+		double value = strtod(p, &num);
+
+		if (num == p || ch < 0)
+			errors++;
+		else
+			sink->sample(ch, value, time);
+
+		p = num;
+		while (p < end && *p != ',') p++;
+	}
+}
+
+void FrameParser::feed(const char *data, size_t len, double time, TelemetrySink *sink) {
+	for (size_t i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if (c == TELEMETRY_DELIMITER) {
+			if (overflow)
+				errors++;
+			else if (length)
+				parseFrame(time, sink);
+
+			length = 0;
+			overflow = false;
+		}
+		else if (length < sizeof(frame)) {
+			frame[length++] = c;
+		}
+		else {
+			overflow = true;
+		}
+	}
+}
+
+void FrameParser::parseFrame(double time, TelemetrySink *sink) {
+	uint8_t payload[TELEMETRY_FRAME_LEN];
+	struct telemetry t;
+
+	if (telemetry_decode(payload, frame, length) != TELEMETRY_PAYLOAD_LEN ||
+	    telemetry_unpack(&t, payload)) {
+		errors++;
+		return;
+	}
+
+	if (synced)
+		lost += (uint8_t) (t.seq - seq - 1);
+
+	seq = t.seq;
+	synced = true;
+
+	sink->sample(CH_ADC_STERING_LEFT, t.adc[0], time);
+	sink->sample(CH_ADC_STERING_RIGHT, t.adc[1], time);
+	sink->sample(CH_ADC_BATT_LOGIC, t.adc[2], time);
+	sink->sample(CH_ADC_BATT_DRIVE, t.adc[3], time);
+	sink->sample(CH_SPEED, t.speed, time);
+	sink->sample(CH_OUT_STERING, t.out_stering, time);
+	sink->sample(CH_OUT_DRIVE, t.out_drive, time);
+}
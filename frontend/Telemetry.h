@@ -0,0 +1,107 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stddef.h>
+
+#include "../controller/telemetry.h"
+
+/**
+ * Telemetry channels of the car (see controller/main.c)
+ */
+enum channel {
+	CH_SPEED,
+	CH_ADC_STERING_LEFT,
+	CH_ADC_STERING_RIGHT,
+	CH_ADC_BATT_LOGIC,
+	CH_ADC_BATT_DRIVE,
+	CH_OUT_STERING,
+	CH_OUT_DRIVE,
+	CHANNELS
+};
+
+/**
+ * Receiver of decoded telemetry values
+ */
+class TelemetrySink {
+
+  public:
+	virtual ~TelemetrySink() { }
+
+	virtual void sample(unsigned channel, double value, double time) = 0;
+};
+
+/**
+ * Decoder for the byte stream received from the car
+ */
+class TelemetryParser {
+
+  public:
+	TelemetryParser() : errors(0) { }
+	virtual ~TelemetryParser() { }
+
+	/**
+	 * Parse a chunk of the stream, may end in the middle of a record
+	 *
+	 * @param time	Reception time of the chunk
+	 */
+	virtual void feed(const char *data, size_t len, double time, TelemetrySink *sink) = 0;
+
+	/* number of malformed records */
+	unsigned long long getErrors() const { return errors; }
+
+	/**
+	 * Find a channel by its name or by the short key used on the wire
+	 *
+	 * @return channel or -1 if unknown
+	 */
+	static int lookup(const char *name, size_t len);
+	static int lookup(const char *name);
+
+	static const char * getName(unsigned channel);
+
+  protected:
+	unsigned long long errors;
+};
+
+/**
+ * Parser for the text format "spd=%i, adc_r=%i, adc_l=%i, ..." terminated by CR/LF
+ */
+class TextParser : public TelemetryParser {
+
+  public:
+	TextParser() : length(0), overflow(false) { }
+
+	void feed(const char *data, size_t len, double time, TelemetrySink *sink);
+
+  protected:
+	char line[256];
+	size_t length;
+	bool overflow;
+
+	void parseLine(double time, TelemetrySink *sink);
+};
+
+/**
+ * Parser for the binary frames of controller/telemetry.h
+ */
+class FrameParser : public TelemetryParser {
+
+  public:
+	FrameParser() : length(0), overflow(false), synced(false), lost(0) { }
+
+	void feed(const char *data, size_t len, double time, TelemetrySink *sink);
+
+	/* frames missing according to the sequence numbers */
+	unsigned long long getLost() const { return lost; }
+
+  protected:
+	uint8_t frame[TELEMETRY_FRAME_LEN];
+	size_t length;
+	bool overflow, synced;
+	uint8_t seq;
+	unsigned long long lost;
+
+	void parseFrame(double time, TelemetrySink *sink);
+};
+
+#endif /* _TELEMETRY_H_ */
@@ -0,0 +1,143 @@
+#include "Transform.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define TRANSFORM_X86
+  #include <immintrin.h>
+#endif
+
+static void samplesScalar(const double *values, size_t n, size_t first, double x0, double step, double offset, double scale, Point *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i].x = x0 + (double) (first + i) * step;
+		out[i].y = offset - values[i] * scale;
+	}
+}
+
+static void pointsScalar(const Point *in, size_t n, double x0, double step, double offset, double scale, Point *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i].x = x0 + in[i].x * step;
+		out[i].y = offset - in[i].y * scale;
+	}
+}
+
+#ifdef TRANSFORM_X86
+/* no FMA: the rounding has to match the scalar kernels */
+
+__attribute__((target("sse2")))
+static void samplesSse2(const double *values, size_t n, size_t first, double x0, double step, double offset, double scale, Point *out) {
+	const __m128d vx0 = _mm_set1_pd(x0), vstep = _mm_set1_pd(step);
+	const __m128d voffset = _mm_set1_pd(offset), vscale = _mm_set1_pd(scale);
+	const __m128d two = _mm_set1_pd(2);
+	__m128d index = _mm_set_pd((double) first + 1, (double) first);
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2) {
+		__m128d x = _mm_add_pd(vx0, _mm_mul_pd(index, vstep));
+		__m128d y = _mm_sub_pd(voffset, _mm_mul_pd(_mm_loadu_pd(values + i), vscale));
+
+		_mm_storeu_pd(&out[i].x, _mm_unpacklo_pd(x, y));
+		_mm_storeu_pd(&out[i + 1].x, _mm_unpackhi_pd(x, y));
+
+		index = _mm_add_pd(index, two);
+	}
+
+	samplesScalar(values + i, n - i, first + i, x0, step, offset, scale, out + i);
+}
+
+__attribute__((target("sse2")))
+static void pointsSse2(const Point *in, size_t n, double x0, double step, double offset, double scale, Point *out) {
+	const __m128d add = _mm_set_pd(offset, x0), mul = _mm_set_pd(-scale, step);
+
+	for (size_t i = 0; i < n; i++)
+		_mm_storeu_pd(&out[i].x, _mm_add_pd(add, _mm_mul_pd(_mm_loadu_pd(&in[i].x), mul)));
+}
+
+__attribute__((target("avx")))
+static void samplesAvx(const double *values, size_t n, size_t first, double x0, double step, double offset, double scale, Point *out) {
+	const __m256d vx0 = _mm256_set1_pd(x0), vstep = _mm256_set1_pd(step);
+	const __m256d voffset = _mm256_set1_pd(offset), vscale = _mm256_set1_pd(scale);
+	const __m256d four = _mm256_set1_pd(4);
+	__m256d index = _mm256_set_pd((double) first + 3, (double) first + 2, (double) first + 1, (double) first);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_add_pd(vx0, _mm256_mul_pd(index, vstep));
+		__m256d y = _mm256_sub_pd(voffset, _mm256_mul_pd(_mm256_loadu_pd(values + i), vscale));
+
+		/* x0 y0 x2 y2 | x1 y1 x3 y3 -> x0 y0 x1 y1 | x2 y2 x3 y3 */
+		__m256d lo = _mm256_unpacklo_pd(x, y);
+		__m256d hi = _mm256_unpackhi_pd(x, y);
+
+		_mm256_storeu_pd(&out[i].x, _mm256_permute2f128_pd(lo, hi, 0x20));
+		_mm256_storeu_pd(&out[i + 2].x, _mm256_permute2f128_pd(lo, hi, 0x31));
+
+		index = _mm256_add_pd(index, four);
+	}
+
+	samplesScalar(values + i, n - i, first + i, x0, step, offset, scale, out + i);
+}
+
+__attribute__((target("avx")))
+static void pointsAvx(const Point *in, size_t n, double x0, double step, double offset, double scale, Point *out) {
+	const __m256d add = _mm256_set_pd(offset, x0, offset, x0), mul = _mm256_set_pd(-scale, step, -scale, step);
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+		_mm256_storeu_pd(&out[i].x, _mm256_add_pd(add, _mm256_mul_pd(_mm256_loadu_pd(&in[i].x), mul)));
+
+	pointsScalar(in + i, n - i, x0, step, offset, scale, out + i);
+}
+#endif
+
+enum Transform::Isa Transform::isa = ISA_SCALAR;
+Transform::SamplesKernel Transform::samplesKernel = samplesScalar;
+Transform::PointsKernel Transform::pointsKernel = pointsScalar;
+
+static bool initialized = Transform::select(Transform::ISA_AUTO);
+
+bool Transform::select(enum Isa want) {
+#ifdef TRANSFORM_X86
+	__builtin_cpu_init();
+
+	if (want == ISA_AUTO)
+		want = __builtin_cpu_supports("avx") ? ISA_AVX : __builtin_cpu_supports("sse2") ? ISA_SSE2 : ISA_SCALAR;
+
+	switch (want) {
+		case ISA_AVX:
+			if (!__builtin_cpu_supports("avx")) return false;
+			samplesKernel = samplesAvx;
+			pointsKernel = pointsAvx;
+			break;
+
+		case ISA_SSE2:
+			if (!__builtin_cpu_supports("sse2")) return false;
+			samplesKernel = samplesSse2;
+			pointsKernel = pointsSse2;
+			break;
+
+		default:
+			samplesKernel = samplesScalar;
+			pointsKernel = pointsScalar;
+			break;
+	}
+#else
+	if (want == ISA_AUTO)
+		want = ISA_SCALAR;
+
+	if (want != ISA_SCALAR)
+		return false;
+#endif
+
+	isa = want;
+	(void) initialized;
+
+	return true;
+}
+
+const char * Transform::getName(enum Isa isa) {
+	switch (isa) {
+		case ISA_SCALAR: return "scalar";
+		case ISA_SSE2:   return "sse2";
+		case ISA_AVX:    return "avx";
+		default:         return "auto";
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef _TRANSFORM_H_
+#define _TRANSFORM_H_
+
+#include <stddef.h>
+
+#include "Decimator.h"
+
+/**
+ * Batch mapping of samples to pixel coordinates
+ *
+ * x = x0 + index * step and y = offset - value * scale for a whole run of
+ * samples at once, with SSE2 or AVX if the CPU has it. All kernels give
+ * bit-identical results. The output feeds the path builder of PlotSeries.
+ */
+class Transform {
+
+  public:
+	enum Isa {
+		ISA_SCALAR,
+		ISA_SSE2,
+		ISA_AVX,
+		ISA_AUTO	/* best one supported by the CPU */
+	};
+
+	/**
+	 * Select the kernels, e.g. to compare them in a benchmark
+	 *
+	 * @return false if the CPU does not support the instruction set
+	 */
+	static bool select(enum Isa isa);
+	static enum Isa getIsa() { return isa; }
+	static const char * getName(enum Isa isa);
+
+	/**
+	 * Samples with consecutive indices starting at first
+	 */
+	static void samples(const double *values, size_t n, size_t first, double x0, double step, double offset, double scale, Point *out) {
+		samplesKernel(values, n, first, x0, step, offset, scale, out);
+	}
+
+	/**
+	 * Points in sample space (x is the index), e.g. from the Decimator
+	 */
+	static void points(const Point *in, size_t n, double x0, double step, double offset, double scale, Point *out) {
+		pointsKernel(in, n, x0, step, offset, scale, out);
+	}
+
+  protected:
+	typedef void (*SamplesKernel)(const double *, size_t, size_t, double, double, double, double, Point *);
+	typedef void (*PointsKernel)(const Point *, size_t, double, double, double, double, Point *);
+
+	static enum Isa isa;
+	static SamplesKernel samplesKernel;
+	static PointsKernel pointsKernel;
+};
+
+#endif /* _TRANSFORM_H_ */
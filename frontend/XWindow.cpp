@@ -22,7 +22,7 @@ XWindow::XWindow(const char *title, int x, int y, int width, int height, unsigne
 	window = XCreateSimpleWindow(display, rootWindow, x, y, width, height, 0, 0, background);
 
 	XStoreName(display, window, title);
-	XSelectInput(display, window, ExposureMask | ButtonPressMask);
+	XSelectInput(display, window, ExposureMask | FocusChangeMask | ButtonPressMask | ButtonReleaseMask | Button1MotionMask | StructureNotifyMask);
 	XMapWindow(display, window);
 }
 
@@ -27,6 +27,7 @@ class XWindow {
 	Visual * getVisual() { return XDefaultVisual(display, screen); };
 
 	static Display * getDisplay();
+	static bool isConnected() { return display != NULL; }
 
 	static void connect(std::string display);
 	static void disconnect();
@@ -0,0 +1,787 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <math.h>
+
+#include "Plot.h"
+#include "Serial.h"
+#include "Recorder.h"
+#include "Archive.h"
+#include "Rasterizer.h"
+#include "Governor.h"
+#include "Profiler.h"
+#include "Clock.h"
+
+/**
+ * Autoscale: incremental extrema vs. rescanning the window every frame
+ */
+static void benchAutoscale() {
+	Color white = { 1, 1, 1 };
+	const int frames = 200, perFrame = 100; /* new samples per frame */
+
+	printf("%10s %12s %20s %20s\n", "window", "push [ns]", "tracked [ns/frame]", "rescan [ns/frame]");
+
+	for (size_t window = 1000; window <= 1000000; window *= 10) {
+		PlotSeries series(PlotSeries::STYLE_LINE, white, window);
+		double value = 0, sink = 0;
+
+		for (size_t i = 0; i < window; i++) {
+			value += -10 + rand()%21;
+			series.push_back(value);
+		}
+
+		/* push cost including extrema maintenance */
+		double start = Clock::now();
+		for (int f = 0; f < frames * perFrame; f++) {
+			value += -10 + rand()%21;
+			series.push_back(value);
+		}
+		double push = (Clock::now() - start) / (frames * perFrame);
+
+		/* autoscale query */
+		start = Clock::now();
+		for (int f = 0; f < frames; f++) {
+			sink += series.max() - series.min();
+		}
+		double tracked = (Clock::now() - start) / frames;
+
+		/* full rescan as done before */
+		start = Clock::now();
+		for (int f = 0; f < frames; f++) {
+			const double *span[2];
+			size_t len[2];
+			series.spans(&span[0], &len[0], &span[1], &len[1]);
+
+			double min = span[0][0], max = span[0][0];
+			for (int s = 0; s < 2; s++) {
+				for (size_t j = 0; j < len[s]; j++) {
+					if (span[s][j] > max) max = span[s][j];
+					if (span[s][j] < min) min = span[s][j];
+				}
+			}
+			sink += max - min;
+		}
+		double rescan = (Clock::now() - start) / frames;
+
+		printf("%10zu %12.1f %20.1f %20.1f\n", window, push * 1e9, tracked * 1e9, rescan * 1e9);
+
+		if (sink == 0) printf("\n"); /* keep results alive */
+	}
+}
+
+struct Generator {
+	int fd;
+	double duration;
+	bool binary;
+};
+
+/**
+ * Feed the firmware's text or binary format into the master side of a pty
+ */
+static void * generate(void *arg) {
+	Generator *gen = (Generator *) arg;
+	char buf[4096];
+	size_t len = 0;
+	int i = 0;
+
+	double end = Clock::now() + gen->duration;
+	while (Clock::now() < end) {
+		len = 0;
+		while (len < sizeof(buf) - 128) {
+			if (gen->binary) {
+				struct telemetry t = {
+					(uint8_t) i, (uint16_t) i,
+					{ (uint16_t) (512 - i % 100), (uint16_t) (512 + i % 100), 800, 700 },
+					(uint8_t) (i % 200), (int8_t) (i % 128 - 64), (uint8_t) (i % 256)
+				};
+				uint8_t payload[TELEMETRY_PAYLOAD_LEN];
+
+				telemetry_pack(payload, &t);
+				len += telemetry_encode((uint8_t *) buf + len, payload, sizeof(payload));
+			}
+			else {
+				len += snprintf(buf + len, sizeof(buf) - len,
+					"spd=%i, adc_r=%i, adc_l=%i, stering=%i, drive=%i\r\n",
+					i % 200, 512 + i % 100, 512 - i % 100, i % 128 - 64, i % 256);
+			}
+			i++;
+		}
+
+		if (write(gen->fd, buf, len) < 0) break;
+	}
+
+	return NULL;
+}
+
+/**
+ * Serial ingestion throughput against a pseudo-terminal pair
+ */
+static void benchSerial(bool binary) {
+	Color white = { 1, 1, 1 };
+	Generator gen = { posix_openpt(O_RDWR | O_NOCTTY), 2.0, binary };
+
+	if (gen.fd < 0 || grantpt(gen.fd) || unlockpt(gen.fd)) {
+		perror("posix_openpt");
+		return;
+	}
+
+	TelemetryParser *parser = binary ? (TelemetryParser *) new FrameParser : new TextParser;
+	SerialAcquisition acq(ptsname(gen.fd), 57600, parser);
+	PlotSeries *series[CHANNELS];
+
+	for (int i = 0; i < CHANNELS; i++) {
+		series[i] = new PlotSeries(PlotSeries::STYLE_LINE, white, 4096);
+		acq.setSeries(TelemetryParser::getName(i), series[i]);
+	}
+
+	pthread_t thread;
+	acq.start();
+	pthread_create(&thread, NULL, generate, &gen);
+
+	/* render thread: drain the queue like the EventLoop does */
+	double start = Clock::now();
+	while (Clock::now() - start < gen.duration + 0.2) {
+		acq.handleEvent(acq.getFd());
+		usleep(1000);
+	}
+
+	pthread_join(thread, NULL);
+	acq.stop();
+	acq.handleEvent(acq.getFd());
+
+	double elapsed = Clock::now() - start;
+	unsigned long long plotted = 0;
+	for (int i = 0; i < CHANNELS; i++) {
+		plotted += series[i]->getPushed();
+		delete series[i];
+	}
+
+	printf("serial (%s): %.0f bytes/s, %.1f bytes/sample, %.0f samples/s parsed, %.0f samples/s plotted, %llu errors, %llu drops (high-water %zu)\n",
+		binary ? "binary" : "text", acq.getBytes() / elapsed, (double) acq.getBytes() / acq.getSamples(), acq.getSamples() / elapsed, plotted / elapsed,
+		acq.getErrors(), acq.getDrops(), acq.getHighWater());
+
+	close(gen.fd);
+}
+
+/**
+ * Ingest path without a thread: parse binary frames and queue the samples
+ */
+class IngestBench : public Acquisition, public TelemetrySink {
+
+  public:
+	IngestBench() : Acquisition(1 << 16) { }
+
+	void sample(unsigned channel, double value, double time) {
+		push(channel, value, time);
+	}
+
+  protected:
+	void run() { }
+};
+
+/**
+ * Cost of the flight recorder on the acquisition thread
+ */
+static void benchRecorder() {
+	Color white = { 1, 1, 1 };
+	const int frames = 4096, rounds = 200;
+	const char *path = "/tmp/benchmark.rec";
+	const char *names[CHANNELS];
+	char *buf = new char[frames * TELEMETRY_FRAME_LEN];
+	size_t len = 0;
+	double cpu[2];
+
+	for (int i = 0; i < frames; i++) {
+		struct telemetry t = {
+			(uint8_t) i, (uint16_t) i,
+			{ (uint16_t) (512 - i % 100), (uint16_t) (512 + i % 100), 800, 700 },
+			(uint8_t) (i % 200), (int8_t) (i % 128 - 64), (uint8_t) (i % 256)
+		};
+		uint8_t payload[TELEMETRY_PAYLOAD_LEN];
+
+		telemetry_pack(payload, &t);
+		len += telemetry_encode((uint8_t *) buf + len, payload, sizeof(payload));
+	}
+
+	for (int i = 0; i < CHANNELS; i++)
+		names[i] = TelemetryParser::getName(i);
+
+	for (int rec = 0; rec < 2; rec++) {
+		IngestBench acq;
+		FrameParser parser;
+		Recorder *recorder = NULL;
+		PlotSeries series(PlotSeries::STYLE_LINE, white, 1);
+
+		acq.setChannel(0, &series);
+
+		if (rec) {
+			unlink(path);
+			recorder = new Recorder(path, 1 << 20, names, CHANNELS);
+			acq.setRecorder(recorder);
+		}
+
+		/* only the acquisition side is timed, draining is the render thread's job */
+		cpu[rec] = 0;
+		for (int r = 0; r < rounds; r++) {
+			double start = Clock::now();
+			parser.feed(buf, len, start, &acq);
+			cpu[rec] += Clock::now() - start;
+
+			acq.handleEvent(acq.getFd());
+		}
+
+		cpu[rec] /= (double) rounds * frames * CHANNELS;
+
+		delete recorder;
+	}
+
+	unlink(path);
+	delete[] buf;
+
+	printf("recorder: %.1f ns/sample ingest, %.1f ns/sample recorded (+%.1f%%), %.2f%% of a core at 100k samples/s\n",
+		cpu[0] * 1e9, cpu[1] * 1e9, 100 * (cpu[1] / cpu[0] - 1), 100 * (cpu[1] - cpu[0]) * 1e5);
+}
+
+/**
+ * Zoom and pan over a long history, rendered from the pyramid
+ */
+static void benchHistory() {
+	Color white = { 1, 1, 1 };
+	const unsigned long long samples = 100000000;
+	const int width = 800, height = 400, frames = 200;
+	PlotSeries series(PlotSeries::STYLE_LINE, white, 1 << 16);
+	double value = 0, start, push, worst = 0, total = 0;
+
+	start = Clock::now();
+	for (unsigned long long i = 0; i < samples; i++) {
+		value += -10 + rand()%21;
+		series.push_back(value);
+	}
+	push = (Clock::now() - start) / samples;
+
+	RefPtr<ImageSurface> surface = ImageSurface::create(FORMAT_RGB24, width, height);
+	RefPtr<Context> ctx = Context::create(surface);
+	Rect area = { 20, 20, width - 40.0, height - 40.0 };
+
+	/* from the whole history down to single samples, panned randomly */
+	for (int f = 0; f < frames; f++) {
+		double span = samples / pow(10, 7.0 * f / frames);
+		double from = (samples - span) * (rand() / (double) RAND_MAX);
+
+		start = Clock::now();
+		ctx->set_source_rgb(0, 0, 0);
+		ctx->paint();
+		series.drawHistory(ctx, area, from, from + span);
+		surface->flush();
+
+		double elapsed = Clock::now() - start;
+		total += elapsed;
+		if (elapsed > worst) worst = elapsed;
+	}
+
+	printf("history: %llu samples, %.1f ns/sample push, %u levels, %.2f ms/frame avg, %.2f ms max (budget 20 ms)\n",
+		samples, push * 1e9, series.getHistory().getLevels(), total / frames * 1e3, worst * 1e3);
+}
+
+/**
+ * Compression and time-range queries of the archive
+ *
+ * Two hours of simulated telemetry: 7 channels at the frame rate of the
+ * firmware with slowly varying ADC counts and sensor noise.
+ */
+static void benchArchive() {
+	const char *path = "/tmp/benchmark.arc";
+	const double rate = 244.140625, duration = 2 * 3600;
+	const char *names[CHANNELS];
+	std::vector<Sample> samples;
+	unsigned long long bytes;
+	double start, write, read, query;
+
+	for (int i = 0; i < CHANNELS; i++)
+		names[i] = TelemetryParser::getName(i);
+
+	samples.reserve(rate * duration * 7);
+	for (unsigned long n = 0; n < rate * duration; n++) {
+		double t = n / rate;
+		double y = 0.3 * sin(t * 0.7) + 0.1 * sin(t * 3.1); /* lateral offset */
+		int noise = rand() % 7 - 3;
+		int left = 500 - 300 * y + noise, right = 500 + 300 * y - noise;
+		int stering = -100 * y;
+
+		Sample s[7] = {
+			{ t, 0, (double) left },
+			{ t, 1, (double) right },
+			{ t, 2, (double) (800 - (int) (t / 60)) },		/* battery */
+			{ t, 3, (double) (600 + rand() % 3) },
+			{ t, 4, (double) (120 + (int) (40 * sin(t * 0.2))) },	/* speed */
+			{ t, 5, (double) stering },
+			{ t, 6, (double) (75 + ((100 * (128 - abs(stering))) >> 8)) }
+		};
+
+		samples.insert(samples.end(), s, s + 7);
+	}
+
+	start = Clock::now();
+	{
+		ArchiveWriter writer(path, names, 7);
+
+		for (size_t i = 0; i < samples.size(); i++)
+			writer.append(samples[i]);
+
+		writer.flush();
+		bytes = writer.getBytes();
+	}
+	write = Clock::now() - start;
+
+	ArchiveReader reader(path);
+	std::vector<Sample> out;
+
+	start = Clock::now();
+	for (unsigned c = 0; c < 7; c++)
+		reader.read(c, reader.getFirst(), reader.getLast(), out);
+	read = Clock::now() - start;
+
+	if (out.size() != samples.size()) {
+		fprintf(stderr, "archive: read %zu of %zu samples\n", out.size(), samples.size());
+		exit(EXIT_FAILURE);
+	}
+
+	/* 10 s window in the middle, like scrolling back in a plot */
+	const int queries = 100;
+	unsigned long long chunks = reader.getChunksRead();
+
+	start = Clock::now();
+	for (int q = 0; q < queries; q++) {
+		double from = duration / 2 + q;
+
+		out.clear();
+		reader.read(0, from, from + 10, out);
+	}
+	query = (Clock::now() - start) / queries;
+	chunks = (reader.getChunksRead() - chunks) / queries;
+
+	unlink(path);
+
+	printf("archive: %zu samples, %.1f M samples/s write, %.1f M samples/s read\n",
+		samples.size(), samples.size() / write * 1e-6, samples.size() / read * 1e-6);
+	printf("archive: %.2f bytes/sample, %.1fx smaller than raw (16 bytes), %.1fx than the recorder (%zu bytes)\n",
+		(double) bytes / samples.size(), 16.0 * samples.size() / bytes,
+		(double) sizeof(RecorderRecord) * samples.size() / bytes, sizeof(RecorderRecord));
+	printf("archive: 10 s query %.1f us, %llu of %zu chunks read, %zu samples\n",
+		query * 1e6, chunks, reader.getChunks(), out.size());
+}
+
+/**
+ * Value to pixel transform: per point vs. batched SIMD
+ *
+ * A 1M point series is bound by the memory bandwidth, PlotSeries::draw()
+ * transforms blocks of PlotSeries::BLOCK points which stay in the cache.
+ */
+static void benchTransform(size_t n, int rounds) {
+	std::vector<double> values(n);
+	std::vector<Point> in(n), ref(n), out(n);
+	double x0 = 20, step = 760.0 / (n - 1), offset = 380, scale = 0.37, sink = 0;
+	enum Transform::Isa saved = Transform::getIsa();
+
+	for (size_t i = 0; i < n; i++) {
+		values[i] = rand() % 1024;
+		in[i].x = i;
+		in[i].y = values[i];
+	}
+
+	/* before: coordinates computed one by one as in the line_to() loop */
+	double start = Clock::now();
+	for (int r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < n; i++) {
+			ref[i].x = x0 + i * step;
+			ref[i].y = offset - values[i] * scale;
+		}
+		sink += ref[r].y;
+	}
+	double before = (Clock::now() - start) / rounds;
+
+	printf("transform %zu points: per point %.0f M points/s\n", n, n / before * 1e-6);
+
+	for (int isa = Transform::ISA_SCALAR; isa < Transform::ISA_AUTO; isa++) {
+		if (!Transform::select((enum Transform::Isa) isa))
+			continue;
+
+		double samples, points;
+		size_t mismatches = 0;
+
+		start = Clock::now();
+		for (int r = 0; r < rounds; r++) {
+			Transform::samples(&values[0], n, 0, x0, step, offset, scale, &out[0]);
+			sink += out[r].y;
+		}
+		samples = (Clock::now() - start) / rounds;
+
+		for (size_t i = 0; i < n; i++)
+			mismatches += (out[i].x != ref[i].x || out[i].y != ref[i].y);
+
+		start = Clock::now();
+		for (int r = 0; r < rounds; r++) {
+			Transform::points(&in[0], n, x0, step, offset, scale, &out[0]);
+			sink += out[r].y;
+		}
+		points = (Clock::now() - start) / rounds;
+
+		for (size_t i = 0; i < n; i++)
+			mismatches += (out[i].x != ref[i].x || out[i].y != ref[i].y);
+
+		printf("transform %zu points: %-6s %.0f M samples/s, %.0f M points/s, %zu mismatches\n",
+			n, Transform::getName((enum Transform::Isa) isa), n / samples * 1e-6, n / points * 1e-6, mismatches);
+	}
+
+	Transform::select(saved);
+
+	if (sink == 42) printf("\n"); /* keep the loops */
+}
+
+/**
+ * Rendering alone, into an offscreen target
+ */
+static void benchRender() {
+	Color blue = { 0, 0, 1 }, red = { 1, 0, 0 };
+	const int frames = 200;
+	ImageTarget *target = new ImageTarget(800, 400);
+	Plot plot(target);
+	PlotSeries left(PlotSeries::STYLE_LINE, blue, 4096), right(PlotSeries::STYLE_LINE, red, 4096);
+	double value = 0, render = 0;
+
+	plot.series.push_back(&left);
+	plot.series.push_back(&right);
+
+	for (int f = 0; f < frames; f++) {
+		for (int i = 0; i < 100; i++) { /* new samples per frame */
+			value += -10 + rand()%21;
+			left.push_back(value);
+			right.push_back(-value);
+		}
+
+		plot.update();
+		render += plot.getRenderTime();
+	}
+
+	printf("render 800x400 offscreen: %.3f ms/frame, %lu frames presented\n",
+		render / frames * 1e3, target->getFrames());
+}
+
+/**
+ * Direct rasterization of 1 px polylines into an 800x400 image
+ */
+static void benchRaster() {
+	const int width = 800, height = 400, n = 1000000;
+	RefPtr<ImageSurface> image = ImageSurface::create(FORMAT_RGB24, width, height);
+	std::vector<Point> walk(n);
+	double lengths[] = { 2, 20 };
+
+	for (int l = 0; l < 2; l++) {
+		/* random walk with segments of about the given length, partly outside */
+		double x = width / 2, y = height / 2;
+		for (int i = 0; i < n; i++) {
+			x += lengths[l] * (rand() / (double) RAND_MAX - 0.5) * 1.4;
+			y += lengths[l] * (rand() / (double) RAND_MAX - 0.5) * 1.4;
+			if (x < -20 || x > width + 20) x = width / 2;
+			if (y < -20 || y > height + 20) y = height / 2;
+			walk[i].x = x;
+			walk[i].y = y;
+		}
+
+		for (int aa = 0; aa < 2; aa++) {
+			Rasterizer r(image->get_data(), width, height, image->get_stride(), aa);
+			double start = Clock::now();
+
+			r.moveTo(walk[0].x, walk[0].y);
+			for (int i = 1; i < n; i++)
+				r.lineTo(walk[i].x, walk[i].y);
+
+			double elapsed = Clock::now() - start;
+			printf("raster %dx%d %s, %.0f px segments: %.1f M segments/s\n", width, height,
+				aa ? "wu" : "bresenham", lengths[l], r.getSegments() / elapsed * 1e-6);
+		}
+	}
+
+	/* whole series, cairo vs. raster */
+	Color blue = { 0, 0, 1 };
+	PlotSeries series(PlotSeries::STYLE_LINE, blue, 100000);
+	RefPtr<Context> ctx = Context::create(image);
+	Rect area = { 20, 20, width - 40, height - 40 };
+	const char *names[] = { "cairo", "raster", "raster wu" };
+	double value = 0;
+
+	for (size_t i = 0; i < series.capacity(); i++) {
+		value += -10 + rand()%21;
+		series.push_back(value);
+	}
+
+	series.lineWidth = 1;
+	series.decimation = PlotSeries::DECIMATION_NONE;
+
+	for (int m = PlotSeries::RASTER_NONE; m <= PlotSeries::RASTER_ANTIALIASED; m++) {
+		const int frames = 20;
+
+		series.raster = (PlotSeries::Raster) m;
+
+		double start = Clock::now();
+		for (int f = 0; f < frames; f++)
+			series.draw(ctx, area);
+		double elapsed = (Clock::now() - start) / frames;
+
+		printf("raster series of %zu samples: %-9s %.3f ms/frame\n", series.capacity(), names[m], elapsed * 1e3);
+	}
+}
+
+/**
+ * Frame time of the styles with 1M samples, e.g. a long steering recording
+ */
+static void benchStyles() {
+	Color blue = { 0, 0, 1 };
+	const char *names[] = { "line", "spline", "scatter" };
+	const int frames = 20;
+	ImageTarget *target = new ImageTarget(800, 400);
+	Plot plot(target);
+	PlotSeries series(PlotSeries::STYLE_LINE, blue, 1000000);
+	double value = 0;
+
+	for (size_t i = 0; i < series.capacity(); i++) {
+		value += -10 + rand()%21;
+		series.push_back(value);
+	}
+
+	plot.series.push_back(&series);
+
+	for (int st = PlotSeries::STYLE_LINE; st <= PlotSeries::STYLE_SCATTER; st++) {
+		double render = 0;
+
+		series.style = (PlotSeries::Style) st;
+
+		for (int f = 0; f < frames; f++) {
+			plot.draw();
+			render += plot.getRenderTime();
+		}
+
+		printf("style %-7s 1M samples 800x400: %.3f ms/frame\n", names[st], render / frames * 1e3);
+	}
+}
+
+/**
+ * Repainted pixels with dirty regions: a dashboard where one of several
+ * series, or only an overlay, changes per frame
+ */
+static void benchDamage() {
+	const int frames = 200, count = 8;
+	Plot plot(new ImageTarget(800, 400));
+	std::vector<PlotSeries *> series;
+
+	for (int k = 0; k < count; k++) {
+		Color color = { (k % 3) / 2.0, ((k + 1) % 3) / 2.0, ((k + 2) % 3) / 2.0 };
+		PlotSeries *s = new PlotSeries(PlotSeries::STYLE_LINE, color, 4096);
+
+		for (int i = 0; i < 2048; i++)
+			s->push_back(rand() % 1000);
+
+		series.push_back(s);
+		plot.series.push_back(s);
+	}
+
+	plot.draw();
+
+	for (int test = 0; test < 3; test++) {
+		const char *names[] = { "full redraw", "one series", "overlay" };
+		unsigned long long repainted = plot.getRepaintedTotal(), presented = plot.getPresentedTotal();
+		double render = 0;
+
+		for (int f = 0; f < frames; f++) {
+			Rect overlay = { 700, 5, 90, 12 };
+
+			switch (test) {
+				case 0: series[f % count]->push_back(rand() % 1000); plot.draw(); break;
+				case 1: series[f % count]->push_back(rand() % 1000); plot.update(); break;
+				case 2: plot.invalidate(overlay); plot.update(); break;
+			}
+
+			render += plot.getRenderTime();
+		}
+
+		printf("damage %d series 800x400, %-11s: %.0f px repainted, %.0f px presented, %.3f ms/frame\n", count, names[test],
+			(double) (plot.getRepaintedTotal() - repainted) / frames,
+			(double) (plot.getPresentedTotal() - presented) / frames, render / frames * 1e3);
+	}
+
+	for (int k = 0; k < count; k++)
+		delete series[k];
+}
+
+/**
+ * Reaction of the quality governor to a synthetic load: a cost which
+ * only fits the budget at the lowest level and is far below it there,
+ * then idle. The restores that fail are held longer each time.
+ */
+static void benchGovernor() {
+	const double budget = 0.010;
+	const double costs[] = { 2, 2, 2, 1.2, 0.4 }; /* per level, in budgets */
+	Governor governor(budget);
+
+	for (int f = 0; f < 2000; f++) {
+		double cost = (f < 1400) ? costs[governor.getLevel()] * budget : 0.2 * budget;
+
+		if (governor.frame(cost))
+			printf("governor: frame %4d -> %s\n", f, Governor::getName(governor.getLevel()));
+	}
+
+	printf("governor: %lu changes\n", governor.getChanges());
+
+	/* no window focused: the plots still get updated at the reduced rate */
+	Color blue = { 0, 0, 1 };
+	Plot plot(new ImageTarget(400, 200));
+	PlotSeries series(PlotSeries::STYLE_LINE, blue, 1000);
+	Governor unfocused(budget);
+	const int ticks = 100;
+	int updates = 0;
+	XEvent e;
+
+	plot.series.push_back(&series);
+	e.type = FocusOut;
+	plot.handleEvent(&e);
+
+	while (unfocused.getLevel() < Governor::LEVEL_UNFOCUSED)
+		unfocused.frame(2 * budget);
+
+	for (int t = 0; t < ticks; t++) {
+		unfocused.tick();
+		series.push_back(t);
+
+		if (unfocused.isDue(&plot) && plot.update())
+			updates++;
+	}
+
+	printf("governor: %d of %d ticks updated without focus\n", updates, ticks);
+	if (updates == 0) {
+		fprintf(stderr, "governor: plots without focus frozen\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * Cost of the stage timers, disabled and enabled, and the timings of a
+ * plot with four series
+ */
+static void benchProfiler() {
+	const int n = 10000000;
+	double sink = 0;
+
+	for (int enabled = 0; enabled < 2; enabled++) {
+		Profiler::setEnabled(enabled);
+
+		double start = Clock::now();
+		for (int i = 0; i < n; i++) {
+			StageTimer timer(Profiler::STAGE_PATH);
+			sink += i;
+		}
+		double elapsed = Clock::now() - start;
+
+		printf("profiler %s: %.1f ns per stage timer\n", enabled ? "enabled" : "disabled", elapsed / n * 1e9);
+	}
+
+	Color blue = { 0, 0, 1 };
+	Plot plot(new ImageTarget(800, 400));
+	std::vector<PlotSeries *> series;
+
+	for (int k = 0; k < 4; k++) {
+		PlotSeries *s = new PlotSeries(PlotSeries::STYLE_LINE, blue, 100000);
+
+		for (size_t i = 0; i < s->capacity(); i++)
+			s->push_back(rand() % 1000);
+
+		series.push_back(s);
+		plot.series.push_back(s);
+	}
+
+	plot.setHud(true);
+
+	for (int f = 0; f < 500; f++) {
+		for (int k = 0; k < 4; k++)
+			series[k]->push_back(rand() % 1000);
+
+		plot.update();
+		Profiler::frame();
+	}
+
+	Profiler::dump(stdout, false);
+	Profiler::setEnabled(false);
+
+	for (int k = 0; k < 4; k++)
+		delete series[k];
+
+	if (sink == 42) printf("\n"); /* keep the loop */
+}
+
+/**
+ * Present time per frame through the X socket vs. MIT-SHM
+ *
+ * Needs an X server, e.g. xvfb-run -s "-screen 0 1920x1080x24" ./benchmark
+ */
+static void benchPresent() {
+	const int sizes[][2] = { { 800, 400 }, { 1920, 1080 } };
+	const int frames = 200;
+	Display *display = XOpenDisplay(NULL);
+
+	if (!display) {
+		printf("present: no X display, skipped\n");
+		return;
+	}
+
+	XCloseDisplay(display);
+	XWindow::connect(getenv("DISPLAY"));
+	display = XWindow::getDisplay();
+
+	for (int i = 0; i < 2; i++) {
+		double present[2];
+		bool shared = false;
+
+		for (int shm = 0; shm < 2; shm++) {
+			WindowTarget *target = new WindowTarget("benchmark", sizes[i][0], sizes[i][1], shm);
+			Plot plot(target);
+			shared = target->isShared();
+
+			XSync(display, False);
+			plot.draw();
+
+			/* including the round trip, XFlush() alone does not wait for the server */
+			double start = Clock::now();
+			for (int f = 0; f < frames; f++) {
+				plot.present();
+				XSync(display, False);
+			}
+			present[shm] = (Clock::now() - start) / frames;
+		}
+
+		printf("present %dx%d: %.3f ms/frame socket, %.3f ms/frame %s (%.1fx)\n",
+			sizes[i][0], sizes[i][1], present[0] * 1e3, present[1] * 1e3,
+			shared ? "shm" : "socket (no MIT-SHM)", present[0] / present[1]);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	benchAutoscale();
+	benchSerial(false);
+	benchSerial(true);
+	benchRecorder();
+	benchArchive();
+	benchHistory();
+	benchTransform(1000000, 50);
+	benchTransform(1024, 50000);
+	benchRender();
+	benchRaster();
+	benchStyles();
+	benchDamage();
+	benchGovernor();
+	benchProfiler();
+	benchPresent();
+
+	return 0;
+}
@@ -1,46 +1,270 @@
 #include "XWindow.h"
 #include "Plot.h"
+#include "EventLoop.h"
+#include "Acquisition.h"
+#include "Serial.h"
+#include "Recorder.h"
+#include "Archive.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "RenderTarget.h"
 
 #include <iostream>
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <signal.h>
+#include <getopt.h>
 
 using namespace Cairo;
 
+enum { DEMO_WAVE, DEMO_WALK, DEMO_CHANNELS };
+
+static const char *demoNames[] = { "wave", "walk" };
+
+/**
+ * Generates demo data with a fixed rate in its own thread
+ */
+class DemoAcquisition : public Acquisition {
+
+  public:
+	DemoAcquisition(double rate)
+	  : rate(rate)
+	{ }
+
+  protected:
+	double rate;
+
+	void run() {
+		double phi = 0, last = 0;
+		double next = Clock::now();
+
+		while (running) {
+			phi += 1e-1;
+			last += -10 + rand()%21;
+
+			double now = Clock::now();
+			push(DEMO_WAVE, 0.7*sin(phi/1e2)*sin(phi * (M_PI/3.0)), now);
+			push(DEMO_WALK, last, now);
+			flush();
+
+			next += 1 / rate;
+			double delay = next - Clock::now();
+			if (delay > 0) usleep(delay * 1e6);
+		}
+	}
+};
+
+static EventLoop *mainLoop;
+
+static const size_t RECORDS = 1 << 22; /* about 40 minutes of telemetry, 96 MiB */
+
+static void quit(int sig) {
+	mainLoop->stop();
+}
+
+/**
+ * X window, or a frame sink if rendering headless
+ */
+static RenderTarget * createTarget(const char *output, FrameSink::Format format, int n) {
+	const int width = 800, height = 400;
+
+	if (!output)
+		return new WindowTarget("Frontend", width, height);
+
+	char path[1024];
+	if (format == FrameSink::FORMAT_PNG)
+		snprintf(path, sizeof(path), "%s%d-", output, n);
+	else
+		snprintf(path, sizeof(path), "%s%d.rgba", output, n);
+
+	return new FrameSink(path, format, width, height);
+}
+
+static void usage(const char *name) {
+	std::cerr << "Usage: " << name << " [-d DISPLAY] [-p PORT] [-b BAUDRATE] [-t] [-r FILE] [-a FILE] [-R FILE] [-s SPEED] [-o PREFIX] [-f FORMAT] [-g MS] [-H] [-T FILE]" << std::endl
+		  << "  -d DISPLAY   X display (default :0)" << std::endl
+		  << "  -p PORT      serial port of the car, e.g. /dev/ttyUSB0 (default: demo data)" << std::endl
+		  << "  -b BAUDRATE  baudrate of the serial port (default 57600)" << std::endl
+		  << "  -t           text telemetry of older firmware instead of binary frames" << std::endl
+		  << "  -r FILE      record all samples to a ring file" << std::endl
+		  << "  -a FILE      archive all samples compressed" << std::endl
+		  << "  -R FILE      replay a recording of the car instead of reading the port" << std::endl
+		  << "  -s SPEED     replay speed, 0 for as fast as possible (default 1)" << std::endl
+		  << "  -o PREFIX    render without X, write the frames of plot N to PREFIX<N>..." << std::endl
+		  << "  -f FORMAT    png (PREFIX<N>-<frame>.png) or raw (RGBA in PREFIX<N>.rgba)" << std::endl
+		  << "  -g MS        frame budget, reduce the quality above it (default 10, 0 to disable)" << std::endl
+		  << "  -H           show the frame timings in the plots" << std::endl
+		  << "  -T FILE      write the frame timings on exit, as JSON if FILE ends with .json, else CSV" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
 int main(int argc, char *argv[]) {
-	XWindow::connect(":0"); // TODO parse from argv
+	const char *display = ":0";
+	const char *port = NULL;
+	const char *record = NULL;
+	const char *archive = NULL;
+	const char *replay = NULL;
+	const char *output = NULL;
+	FrameSink::Format format = FrameSink::FORMAT_PNG;
+	int baudrate = 57600;
+	double speed = 1;
+	double budget = 10;
+	bool text = false;
+	bool hud = false;
+	const char *timings = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:p:b:tr:a:R:s:o:f:g:HT:h")) != -1) {
+		switch (c) {
+			case 'd': display = optarg; break;
+			case 'p': port = optarg; break;
+			case 'b': baudrate = atoi(optarg); break;
+			case 't': text = true; break;
+			case 'r': record = optarg; break;
+			case 'a': archive = optarg; break;
+			case 'R': replay = optarg; break;
+			case 's': speed = atof(optarg); break;
+			case 'o': output = optarg; break;
+			case 'g': budget = atof(optarg); break;
+			case 'H': hud = true; break;
+			case 'T': timings = optarg; break;
+			case 'f':
+				if (!strcmp(optarg, "raw")) format = FrameSink::FORMAT_RAW;
+				else if (strcmp(optarg, "png")) usage(argv[0]);
+				break;
+			default: usage(argv[0]);
+		}
+	}
+
+	if (!output)
+		XWindow::connect(display);
 
-	XEvent e;
 	Color blue = { 0, 0, 1 };
 	Color red = { 1, 0, 0 };
-	Plot testPlot(800, 400);
-	Plot testPlot2(800, 400);
+	Plot testPlot(createTarget(output, format, 1));
+	Plot testPlot2(createTarget(output, format, 2));
+
+	Acquisition *acq;
+	Recorder *recorder = NULL;
+	ArchiveWriter *writer = NULL;
 
-	PlotSeries *demo1 = new PlotSeries(PlotSeries::STYLE_LINE, blue);
-	PlotSeries *demo2 = new PlotSeries(PlotSeries::STYLE_LINE, red);
-	testPlot.series.push_back(demo1);
-	testPlot2.series.push_back(demo2);
+	if (port || replay) {
+		/* inductor sensors */
+		PlotSeries *left = new PlotSeries(PlotSeries::STYLE_LINE, blue, 400);
+		PlotSeries *right = new PlotSeries(PlotSeries::STYLE_LINE, red, 400);
+		testPlot.series.push_back(left);
+		testPlot.series.push_back(right);
 
-	double phi = 0;
-	double last = 0;
+		/* actuators */
+		PlotSeries *stering = new PlotSeries(PlotSeries::STYLE_LINE, blue, 400);
+		PlotSeries *drive = new PlotSeries(PlotSeries::STYLE_LINE, red, 400);
+		testPlot2.series.push_back(stering);
+		testPlot2.series.push_back(drive);
 
-	while (1) {
-		phi += 1e-1;
+		if (replay) {
+			ReplayAcquisition *rep = new ReplayAcquisition(replay, speed);
+			const char *names[] = { "adc_stering_left", "adc_stering_right", "out_stering", "out_drive" };
+			PlotSeries *series[] = { left, right, stering, drive };
 
-		last += -10 + rand()%21;
+			for (int i = 0; i < 4; i++) {
+				if (!rep->setSeries(names[i], series[i])) {
+					std::cerr << replay << ": no channel " << names[i] << " in the recording" << std::endl;
+					exit(EXIT_FAILURE);
+				}
+			}
 
-		demo2->push_back(last);
+			acq = rep;
+		}
+		else {
+			TelemetryParser *parser = text ? (TelemetryParser *) new TextParser : new FrameParser;
+			SerialAcquisition *serial = new SerialAcquisition(port, baudrate, parser);
+			serial->setSeries("adc_stering_left", left);
+			serial->setSeries("adc_stering_right", right);
+			serial->setSeries("out_stering", stering);
+			serial->setSeries("out_drive", drive);
+
+			const char *names[CHANNELS];
+			for (int i = 0; i < CHANNELS; i++)
+				names[i] = TelemetryParser::getName(i);
 
-		if (demo2->size() > 400) demo2->pop_front();
+			if (record)
+				recorder = new Recorder(record, RECORDS, names, CHANNELS);
+			if (archive)
+				writer = new ArchiveWriter(archive, names, CHANNELS);
 
-		demo1->clear();
-		for (int i = 0; i < 300; i++) {
-			demo1->push_back(0.7*sin(i*phi/1e3)*sin(i * (M_PI/30.0) + phi));
+			acq = serial;
 		}
+	}
+	else {
+		PlotSeries *demo1 = new PlotSeries(PlotSeries::STYLE_LINE, blue, 300);
+		PlotSeries *demo2 = new PlotSeries(PlotSeries::STYLE_LINE, red, 400);
+		testPlot.series.push_back(demo1);
+		testPlot2.series.push_back(demo2);
+		testPlot2.setMode(Plot::MODE_STRIP); /* rolling telemetry */
 
-		usleep(0.2*1e5);
-		testPlot.draw();
-		testPlot2.draw();
+		DemoAcquisition *demo = new DemoAcquisition(50);
+		demo->setChannel(DEMO_WAVE, demo1);
+		demo->setChannel(DEMO_WALK, demo2);
+
+		if (record)
+			recorder = new Recorder(record, RECORDS, demoNames, DEMO_CHANNELS);
+		if (archive)
+			writer = new ArchiveWriter(archive, demoNames, DEMO_CHANNELS);
+
+		acq = demo;
 	}
+
+	acq->setRecorder(recorder);
+	acq->setArchive(writer);
+
+	if (timings) Profiler::setEnabled(true);
+	testPlot.setHud(hud);
+	testPlot2.setHud(hud);
+
+	EventLoop loop(50); /* max. frames per second */
+	Governor governor(budget * 1e-3);
+	if (budget > 0) loop.setGovernor(&governor);
+
+	loop.addPlot(&testPlot);
+	loop.addPlot(&testPlot2);
+	loop.addSource(acq->getFd(), acq);
+
+	mainLoop = &loop;
+	signal(SIGINT, quit);
+	signal(SIGTERM, quit);
+
+	acq->start();
+	loop.run();
+	acq->stop();
+
+	std::cout << "Queue: high-water " << acq->getHighWater() << "/" << acq->getCapacity()
+		  << ", drops " << acq->getDrops() << std::endl;
+
+	if (budget > 0)
+		std::cout << "Quality: " << Governor::getName(governor.getLevel()) << ", " << governor.getChanges()
+			  << " changes, frame time " << governor.getAverage() * 1e3 << " ms" << std::endl;
+
+	if (timings) {
+		size_t len = strlen(timings);
+		bool json = len > 5 && !strcmp(timings + len - 5, ".json");
+
+		FILE *out = fopen(timings, "w");
+		if (!out) {
+			perror(timings);
+			exit(EXIT_FAILURE);
+		}
+
+		Profiler::dump(out, json);
+		fclose(out);
+	}
+
+	delete acq;
+	delete recorder;
+	delete writer; /* writes the index */
+
+	return 0;
 }
@@ -0,0 +1,197 @@
+/**
+ * Rendering benchmark matrix for Plot and PlotSeries
+ *
+ * Renders plots offscreen for all combinations of series count, points per
+ * series, style, antialiasing and surface size. Prints one line per
+ * combination as CSV (or JSON lines) to compare the results of two builds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "Plot.h"
+#include "RenderTarget.h"
+#include "Clock.h"
+
+/* allocations of all libraries (cairo, pixman, libstdc++) through libc */
+extern "C" {
+	void * __libc_malloc(size_t size);
+	void * __libc_calloc(size_t n, size_t size);
+	void * __libc_realloc(void *ptr, size_t size);
+
+	static volatile bool counting = false;
+	static unsigned long long allocs, allocBytes;
+
+	static void count(size_t size) {
+		if (counting) {
+			__atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&allocBytes, size, __ATOMIC_RELAXED);
+		}
+	}
+
+	void * malloc(size_t size) {
+		count(size);
+		return __libc_malloc(size);
+	}
+
+	void * calloc(size_t n, size_t size) {
+		count(n * size);
+		return __libc_calloc(n, size);
+	}
+
+	void * realloc(void *ptr, size_t size) {
+		count(size);
+		return __libc_realloc(ptr, size);
+	}
+}
+
+struct Size {
+	int width, height;
+};
+
+static const char *styleNames[] = { "line", "spline", "scatter" };
+static const char *antialiasNames[] = { "default", "none", "gray", "subpixel" };
+
+static void usage(const char *name) {
+	printf("usage: %s [-q] [-j] [-t SECONDS] [-f FRAMES] [-m POINTS] [-l LABEL] [-o FILE]\n", name);
+	printf("  -q          quick: a reduced matrix\n");
+	printf("  -j          JSON lines instead of CSV\n");
+	printf("  -t SECONDS  minimal time per combination (default 0.2)\n");
+	printf("  -f FRAMES   maximal frames per combination (default 1000)\n");
+	printf("  -m POINTS   skip combinations with more points in total (default 33554432)\n");
+	printf("  -l LABEL    value of the label column, e.g. the revision of the build\n");
+	printf("  -o FILE     write the results to a file instead of stdout\n");
+}
+
+int main(int argc, char *argv[]) {
+	int seriesCounts[] = { 1, 4, 16, 64 };
+	long pointCounts[] = { 100, 1000, 10000, 100000, 1000000, 10000000 };
+	Antialias antialiasModes[] = { ANTIALIAS_NONE, ANTIALIAS_GRAY, ANTIALIAS_SUBPIXEL };
+	Size sizes[] = { { 400, 300 }, { 800, 400 }, { 1920, 1080 } };
+
+	size_t numSeries = 4, numPoints = 6, numStyles = 3, numAntialias = 3, numSizes = 3;
+	double minTime = 0.2;
+	long maxFrames = 1000;
+	unsigned long long maxPoints = 1ULL << 25;
+	const char *label = "";
+	bool json = false;
+	FILE *out = stdout;
+	int c;
+
+	while ((c = getopt(argc, argv, "qjt:f:m:l:o:h")) != -1) {
+		switch (c) {
+			case 'q':
+				/* 1 and 16 series, 1k, 100k and 10M points, line, default size */
+				seriesCounts[1] = 16; numSeries = 2;
+				pointCounts[0] = 1000; pointCounts[1] = 100000; pointCounts[2] = 10000000; numPoints = 3;
+				antialiasModes[0] = ANTIALIAS_NONE; antialiasModes[1] = ANTIALIAS_SUBPIXEL; numAntialias = 2;
+				sizes[0] = sizes[1]; numSizes = 1;
+				numStyles = 1;
+				break;
+
+			case 'j': json = true; break;
+			case 't': minTime = atof(optarg); break;
+			case 'f': maxFrames = atol(optarg); break;
+			case 'm': maxPoints = strtoull(optarg, NULL, 0); break;
+			case 'l': label = optarg; break;
+			case 'o':
+				out = fopen(optarg, "w");
+				if (!out) {
+					perror(optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+
+			default:
+				usage(argv[0]);
+				exit((c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	if (!json)
+		fprintf(out, "label,series,points,style,antialias,width,height,frames,fps,ns_per_point,allocs_per_frame,bytes_per_frame\n");
+
+	for (size_t is = 0; is < numSeries; is++) {
+		for (size_t ip = 0; ip < numPoints; ip++) {
+			int count = seriesCounts[is];
+			long points = pointCounts[ip];
+
+			if ((unsigned long long) count * points > maxPoints) {
+				fprintf(stderr, "skipped %d series with %ld points (-m)\n", count, points);
+				continue;
+			}
+
+			/* random walks, shared by all combinations of this size */
+			std::vector<PlotSeries *> series;
+			for (int k = 0; k < count; k++) {
+				Color color = { (k % 3) / 2.0, ((k + 1) % 3) / 2.0, ((k + 2) % 3) / 2.0 };
+				PlotSeries *s = new PlotSeries(PlotSeries::STYLE_LINE, color, points);
+				double value = 0;
+
+				for (long i = 0; i < points; i++) {
+					value += -10 + rand()%21;
+					s->push_back(value);
+				}
+
+				series.push_back(s);
+			}
+
+			for (size_t st = 0; st < numStyles; st++) {
+				for (size_t ia = 0; ia < numAntialias; ia++) {
+					for (size_t iz = 0; iz < numSizes; iz++) {
+						Plot plot(new ImageTarget(sizes[iz].width, sizes[iz].height));
+
+						plot.setAntialias(antialiasModes[ia]);
+						for (int k = 0; k < count; k++) {
+							series[k]->style = (PlotSeries::Style) st;
+							plot.series.push_back(series[k]);
+						}
+
+						plot.draw(); /* warm up: chrome and scratch buffers */
+
+						allocs = allocBytes = 0;
+						counting = true;
+
+						long frames = 0;
+						double start = Clock::now(), elapsed;
+
+						do {
+							plot.draw();
+							frames++;
+							elapsed = Clock::now() - start;
+						} while (frames < 3 || (elapsed < minTime && frames < maxFrames));
+
+						counting = false;
+
+						double fps = frames / elapsed;
+						double ns = elapsed / frames / ((double) count * points) * 1e9;
+						double allocsPerFrame = (double) allocs / frames;
+						double bytesPerFrame = (double) allocBytes / frames;
+
+						const char *fmt = json
+							? "{\"label\":\"%s\",\"series\":%d,\"points\":%ld,\"style\":\"%s\",\"antialias\":\"%s\","
+							  "\"width\":%d,\"height\":%d,\"frames\":%ld,\"fps\":%.2f,\"ns_per_point\":%.3f,"
+							  "\"allocs_per_frame\":%.1f,\"bytes_per_frame\":%.0f}\n"
+							: "%s,%d,%ld,%s,%s,%d,%d,%ld,%.2f,%.3f,%.1f,%.0f\n";
+
+						fprintf(out, fmt, label, count, points, styleNames[st], antialiasNames[antialiasModes[ia]],
+							sizes[iz].width, sizes[iz].height, frames, fps, ns, allocsPerFrame, bytesPerFrame);
+						fflush(out);
+					}
+				}
+			}
+
+			for (int k = 0; k < count; k++)
+				delete series[k];
+		}
+	}
+
+	if (out != stdout)
+		fclose(out);
+
+	return 0;
+}